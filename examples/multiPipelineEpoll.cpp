@@ -0,0 +1,105 @@
+/* -*- mode: c++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file multiPipelineEpoll.cpp
+ * @brief Runs many pipelines and services all their buses from one thread with epoll, without a GMainLoop.
+ * ./multiPipelineEpoll 100 videotestsrc num-buffers=100 ! fakesink
+ * The program ends when all pipelines have sent EOS or an error.
+ * @author Sandro Stiller
+ * @date 2025-07-18
+ */
+
+#include "pipeline.hpp"
+
+// std
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// C
+#include <sys/epoll.h>
+#include <unistd.h>
+
+int main(const int argc, const char **argv)
+{
+  if(argc < 3)
+  {
+    std::cout << "Usage: " << argv[0] << " <numPipelines> <pipelineDesc>\n";
+    return 1;
+  }
+
+  gst_init(const_cast<int*>(&argc), const_cast<char***>(&argv));
+
+  const int numPipelines = std::stoi(argv[1]);
+  std::ostringstream desc;
+  for(int i = 2; i < argc; ++i)
+  {
+    desc << argv[i] << ' ';
+  }
+
+  struct Entry
+  {
+    std::shared_ptr<dh::gst::Pipeline> pipeline;
+    std::shared_ptr<dh::gst::Bus> bus;
+    bool finished{false};
+  };
+  std::vector<Entry> entries(numPipelines);
+
+  const int epollFd = epoll_create1(0);
+  for(int i = 0; i < numPipelines; ++i)
+  {
+    auto& entry = entries[i];
+    entry.pipeline = dh::gst::Pipeline::create(dh::gst::Pipeline::fromDescription(desc.str()).getGstPipeline());
+    entry.bus = entry.pipeline->getBus();
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u32 = i;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, entry.bus->getPollFd(), &event);
+
+    entry.pipeline->setState(GST_STATE_PLAYING);
+  }
+
+  int running = numPipelines;
+  std::vector<epoll_event> events(64);
+  while(running > 0)
+  {
+    const int numEvents = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+    for(int i = 0; i < numEvents; ++i)
+    {
+      auto& entry = entries[events[i].data.u32];
+      // at most 32 messages per bus and wake up, so one flooding bus can not starve the others
+      entry.bus->drain(
+        [&entry, &running, index = events[i].data.u32](dh::gst::GstMessageSPtr message)
+        {
+          if(entry.finished)
+          {
+            return;
+          }
+          if(GST_MESSAGE_TYPE(message.get()) == GST_MESSAGE_ERROR)
+          {
+            std::cerr << "Pipeline " << index << ": error from '" << GST_MESSAGE_SRC_NAME(message.get()) << "'" << std::endl;
+          }
+          else
+          {
+            std::cout << "Pipeline " << index << ": EOS" << std::endl;
+          }
+          entry.finished = true;
+          --running;
+        },
+        32,
+        static_cast<GstMessageType>(GST_MESSAGE_ERROR | GST_MESSAGE_EOS)
+      );
+    }
+  }
+
+  for(auto& entry : entries)
+  {
+    entry.pipeline->setState(GST_STATE_NULL);
+  }
+  close(epollFd);
+  entries.clear();
+  gst_deinit();
+  return 0;
+}
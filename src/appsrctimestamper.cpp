@@ -0,0 +1,308 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "appsrctimestamper.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+// C
+#include <gst/app/gstappsrc.h>
+
+namespace dh::gst
+{
+
+class AppSrcTimestamper::Private
+{
+public:
+  struct Sample
+  {
+    guint64 index;
+    GstClockTime arrival;
+  };
+
+  GstElementSPtr appSrc;
+  mutable std::mutex mutex;
+
+  std::size_t windowSize{32};
+  GstClockTime discontinuityThreshold{100 * GST_MSECOND};
+  GstClockTime nominalDuration{GST_CLOCK_TIME_NONE};
+
+  // ring buffer with the last windowSize samples, oldest at position first
+  std::vector<Sample> samples = std::vector<Sample>(windowSize);
+  std::size_t first{0};
+  std::size_t count{0};
+
+  GstClockTime lastPts{GST_CLOCK_TIME_NONE};
+  bool pendingDiscont{true};
+
+  const Sample& sampleAt(std::size_t pos) const
+  {
+    return samples[(first + pos) % samples.size()];
+  }
+
+  void addSample(guint64 index, GstClockTime arrival)
+  {
+    if(count < samples.size())
+    {
+      samples[(first + count) % samples.size()] = {index, arrival};
+      ++count;
+    }
+    else
+    {
+      samples[first] = {index, arrival};
+      first = (first + 1) % samples.size();
+    }
+  }
+
+  void clear()
+  {
+    first = 0;
+    count = 0;
+  }
+
+  /**
+   * @brief least squares fit through the samples, relative to the oldest sample to keep the numbers small.
+   * @return false if the fit is not possible
+   */
+  bool fit(double& slope, double& meanX, double& meanY) const
+  {
+    if(count < 2)
+    {
+      return false;
+    }
+    const Sample& origin = sampleAt(0);
+    meanX = 0.0;
+    meanY = 0.0;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      meanX += static_cast<double>(sampleAt(i).index - origin.index);
+      meanY += static_cast<double>(GST_CLOCK_DIFF(origin.arrival, sampleAt(i).arrival));
+    }
+    meanX /= static_cast<double>(count);
+    meanY /= static_cast<double>(count);
+
+    double sxx = 0.0;
+    double sxy = 0.0;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      const double dx = static_cast<double>(sampleAt(i).index - origin.index) - meanX;
+      const double dy = static_cast<double>(GST_CLOCK_DIFF(origin.arrival, sampleAt(i).arrival)) - meanY;
+      sxx += dx * dx;
+      sxy += dx * dy;
+    }
+    if(sxx <= 0.0)
+    {
+      return false;
+    }
+    slope = sxy / sxx;
+    return slope > 0.0;
+  }
+
+  GstClockTime predict(guint64 index, double slope, double meanX, double meanY) const
+  {
+    const Sample& origin = sampleAt(0);
+    const double offset = meanY + slope * (static_cast<double>(index - origin.index) - meanX);
+    const double pts = static_cast<double>(origin.arrival) + offset;
+    return pts <= 0.0 ? 0 : static_cast<GstClockTime>(std::llround(pts));
+  }
+};
+
+AppSrcTimestamper::AppSrcTimestamper(std::shared_ptr<Element> appSrc)
+: prv{std::make_unique<Private>()}
+{
+  if(! appSrc)
+  {
+    throw std::invalid_argument("AppSrcTimestamper: no appsrc given");
+  }
+  prv->appSrc = appSrc->getGstElement();
+  if(! GST_IS_APP_SRC(prv->appSrc.get()))
+  {
+    throw std::invalid_argument("AppSrcTimestamper: Element " + appSrc->getName() + " is not an appsrc");
+  }
+
+  // we do the timestamping, appsrc must not overwrite it
+  g_object_set(
+    G_OBJECT(prv->appSrc.get()),
+    "format", GST_FORMAT_TIME,
+    "do-timestamp", FALSE,
+    nullptr
+  );
+}
+
+AppSrcTimestamper::~AppSrcTimestamper() = default;
+
+std::shared_ptr<AppSrcTimestamper> AppSrcTimestamper::create(std::shared_ptr<Element> appSrc)
+{
+  return std::shared_ptr<AppSrcTimestamper>(new AppSrcTimestamper(std::move(appSrc)));
+}
+
+void AppSrcTimestamper::setWindowSize(std::size_t windowSize)
+{
+  if(windowSize < 2)
+  {
+    throw std::invalid_argument("AppSrcTimestamper: window size must be at least 2");
+  }
+  std::lock_guard lock(prv->mutex);
+  prv->windowSize = windowSize;
+  prv->samples.assign(windowSize, {});
+  prv->clear();
+}
+
+void AppSrcTimestamper::setDiscontinuityThreshold(GstClockTime threshold)
+{
+  std::lock_guard lock(prv->mutex);
+  prv->discontinuityThreshold = threshold;
+}
+
+void AppSrcTimestamper::setNominalDuration(GstClockTime duration)
+{
+  std::lock_guard lock(prv->mutex);
+  prv->nominalDuration = duration;
+}
+
+GstFlowReturn AppSrcTimestamper::push(GstBufferSPtr buffer)
+{
+  if(! buffer)
+  {
+    throw std::invalid_argument("AppSrcTimestamper: empty buffer");
+  }
+
+  // gst_app_src_push_buffer: transfer full
+  GstBuffer* rawBuffer = gst_buffer_ref(buffer.get());
+  buffer.reset(); // if the caller moved the buffer in, we are the only owner now and need no copy
+  rawBuffer = gst_buffer_make_writable(rawBuffer);
+
+  const GstClockTime runningTime = getCurrentRunningTime();
+  if(GST_CLOCK_TIME_IS_VALID(runningTime))
+  {
+    timestamp(*rawBuffer, runningTime);
+  }
+  else
+  {
+    GST_DEBUG("AppSrcTimestamper: appsrc has no clock, pushing buffer without timestamp");
+  }
+
+  return gst_app_src_push_buffer(GST_APP_SRC_CAST(prv->appSrc.get()), rawBuffer);
+}
+
+GstClockTime AppSrcTimestamper::timestamp(GstBuffer& buffer, GstClockTime arrivalRunningTime)
+{
+  std::lock_guard lock(prv->mutex);
+
+  bool discont = prv->pendingDiscont;
+  GstClockTime pts = arrivalRunningTime;
+  guint64 index = prv->count == 0 ? 0 : prv->sampleAt(prv->count - 1).index + 1;
+
+  double slope{0.0};
+  double meanX{0.0};
+  double meanY{0.0};
+  const bool hasFit = ! discont && prv->fit(slope, meanX, meanY);
+  if(hasFit)
+  {
+    const Private::Sample& last = prv->sampleAt(prv->count - 1);
+    const GstClockTime gap = arrivalRunningTime > last.arrival ? arrivalRunningTime - last.arrival : 0;
+    if(static_cast<double>(gap) > slope + static_cast<double>(prv->discontinuityThreshold))
+    {
+      GST_DEBUG("AppSrcTimestamper: discontinuity, no buffer for %" GST_TIME_FORMAT, GST_TIME_ARGS(gap));
+      discont = true;
+    }
+    else
+    {
+      // skip indices of frames that were lost between the last and this push
+      const auto elapsedFrames = static_cast<guint64>(std::llround(static_cast<double>(gap) / slope));
+      index = last.index + std::max<guint64>(1, elapsedFrames);
+
+      const GstClockTime predicted = prv->predict(index, slope, meanX, meanY);
+      const GstClockTime distance = predicted > arrivalRunningTime
+        ? predicted - arrivalRunningTime
+        : arrivalRunningTime - predicted;
+
+      if(distance > prv->discontinuityThreshold)
+      {
+        GST_DEBUG("AppSrcTimestamper: discontinuity, arrival differs by %" GST_TIME_FORMAT, GST_TIME_ARGS(distance));
+        discont = true;
+      }
+      else
+      {
+        pts = predicted;
+      }
+    }
+  }
+
+  if(discont)
+  {
+    prv->clear();
+    index = 0;
+    pts = arrivalRunningTime;
+  }
+  else if(GST_CLOCK_TIME_IS_VALID(prv->lastPts) && pts <= prv->lastPts)
+  {
+    // the fitted line can move backwards when the slope changes; timestamps must not
+    pts = prv->lastPts + 1;
+  }
+
+  prv->addSample(index, arrivalRunningTime);
+  prv->lastPts = pts;
+  prv->pendingDiscont = false;
+
+  GstClockTime duration = prv->nominalDuration;
+  if(! GST_CLOCK_TIME_IS_VALID(duration) && hasFit)
+  {
+    duration = static_cast<GstClockTime>(std::llround(slope));
+  }
+
+  GST_BUFFER_PTS(&buffer) = pts;
+  GST_BUFFER_DTS(&buffer) = pts;
+  GST_BUFFER_DURATION(&buffer) = duration;
+  if(discont)
+  {
+    GST_BUFFER_FLAG_SET(&buffer, GST_BUFFER_FLAG_DISCONT);
+  }
+  return pts;
+}
+
+GstClockTime AppSrcTimestamper::getCurrentRunningTime() const
+{
+  // gst_element_get_clock: transfer full, nullable
+  const auto clock = makeGstSharedPtr(gst_element_get_clock(prv->appSrc.get()), TransferType::Full);
+  if(! clock)
+  {
+    return GST_CLOCK_TIME_NONE;
+  }
+  const GstClockTime now = gst_clock_get_time(clock.get());
+  const GstClockTime baseTime = gst_element_get_base_time(prv->appSrc.get());
+  return now > baseTime ? now - baseTime : 0;
+}
+
+void AppSrcTimestamper::reset()
+{
+  std::lock_guard lock(prv->mutex);
+  prv->clear();
+  prv->lastPts = GST_CLOCK_TIME_NONE;
+  prv->pendingDiscont = true;
+}
+
+} // dh::gst
@@ -0,0 +1,123 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_APPSRCTIMESTAMPER_HPP
+#define DH_GST_APPSRCTIMESTAMPER_HPP
+
+// local includes
+#include "element.hpp"
+#include "sharedptrs.hpp"
+
+// std
+#include <cstddef>
+#include <memory>
+
+// C
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Timestamps buffers that are pushed into an appsrc element.
+ * The PTS is derived from the running time of the appsrc (clock time - base time) at the moment of the push.
+ * Capture jitter is removed by fitting a line (least squares) through the arrival times of the last buffers,
+ * so the resulting timestamps follow the real frame rate of the source instead of the scheduling noise of the pushing thread.
+ * If an arrival time is too far away from the fitted line, a discontinuity is assumed:
+ * the history is dropped and the buffer is flagged with GST_BUFFER_FLAG_DISCONT.
+ *
+ * The appsrc is configured for format=time and do-timestamp=false.
+ * All functions are thread safe.
+ */
+class AppSrcTimestamper
+{
+protected:
+  /**
+   * @brief Create a new AppSrcTimestamper for the given appsrc.
+   * @param appSrc an Element created from the "appsrc" factory
+   * @throws std::invalid_argument if appSrc is empty or not an appsrc
+   */
+  explicit AppSrcTimestamper(std::shared_ptr<Element> appSrc);
+
+public:
+  [[nodiscard]] static std::shared_ptr<AppSrcTimestamper> create(std::shared_ptr<Element> appSrc);
+
+  ~AppSrcTimestamper();
+
+  /**
+   * @brief Set the number of arrival times used for the jitter regression.
+   * A bigger window gives smoother timestamps but reacts slower to rate changes.
+   * @param windowSize number of buffers, at least 2. Default: 32
+   * @throws std::invalid_argument if windowSize < 2
+   */
+  void setWindowSize(std::size_t windowSize);
+
+  /**
+   * @brief Set the maximum distance between the arrival time and the fitted timestamp.
+   * If the distance is bigger, a discontinuity is assumed. Default: 100ms
+   * @param threshold the threshold in nanoseconds
+   */
+  void setDiscontinuityThreshold(GstClockTime threshold);
+
+  /**
+   * @brief Set a fixed duration for all buffers (e.g. 1/framerate).
+   * If not set (GST_CLOCK_TIME_NONE, default), the duration is taken from the fitted frame interval.
+   * @param duration the duration in nanoseconds or GST_CLOCK_TIME_NONE
+   */
+  void setNominalDuration(GstClockTime duration);
+
+  /**
+   * @brief Timestamp the buffer with the current running time of the appsrc and push it.
+   * If the buffer is shared, a metadata copy (no data copy) is pushed.
+   * @param buffer the buffer to push
+   * @return the flow return of the appsrc
+   * @throws std::invalid_argument if buffer is empty
+   */
+  GstFlowReturn push(GstBufferSPtr buffer);
+
+  /**
+   * @brief Set PTS, DTS, duration and DISCONT flag of a buffer for a given arrival time.
+   * This is the timestamping step of @ref push without clock access and without pushing.
+   * @param buffer a writable buffer
+   * @param arrivalRunningTime the running time when the buffer was captured/arrived
+   * @return the PTS that was set
+   */
+  GstClockTime timestamp(GstBuffer& buffer, GstClockTime arrivalRunningTime);
+
+  /**
+   * @brief Get the current running time of the appsrc.
+   * @return the running time or GST_CLOCK_TIME_NONE if the appsrc has no clock yet (not PLAYING)
+   */
+  [[nodiscard]] GstClockTime getCurrentRunningTime() const;
+
+  /**
+   * @brief Drop the arrival history. The next buffer is flagged as discontinuous.
+   * Call this after a flushing seek or when the source was restarted.
+   */
+  void reset();
+
+private:
+  class Private;
+  std::unique_ptr<Private> prv;
+};
+
+} // dh::gst
+
+#endif //DH_GST_APPSRCTIMESTAMPER_HPP
@@ -20,11 +20,362 @@
 
 #include "bin.hpp"
 
+#include <atomic>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
 namespace dh::gst
 {
 
+namespace
+{
+/**
+ * @brief Returns the only pad of the given direction or nullptr if the element has none or several.
+ */
+GstPadSPtr getSinglePad(GstElement* element, GstPadDirection direction)
+{
+  GST_OBJECT_LOCK(element);
+  const GList* pads = direction == GST_PAD_SINK ? element->sinkpads : element->srcpads;
+  GstPad* pad = (pads && ! pads->next) ? GST_PAD_CAST(pads->data) : nullptr;
+  auto result = makeGstSharedPtr(pad, TransferType::None);
+  GST_OBJECT_UNLOCK(element);
+  return result;
+}
+
+/**
+ * @brief State of one Bin::replaceElement call, shared by the pad probes, the drain timeout and the
+ * asynchronous swap. The probes are removed when the swap ends, which releases the references.
+ */
+struct ElementSwap
+{
+  GstBinSPtr bin;
+  GstElementSPtr oldElement;
+  GstPadSPtr upstreamPad;
+  GstPadSPtr oldSinkPad;
+  GstPadSPtr oldSrcPad;
+  GstPadSPtr downstreamPad;
+  GstElementSPtr newElement;
+  GstPadSPtr newSinkPad;
+  GstPadSPtr newSrcPad;
+  GstClockID timeoutId{nullptr};
+
+  std::mutex mutex; // guards the following members
+  gulong blockProbeId{0};
+  gulong eosProbeId{0};
+  bool blocked{false};
+  bool finished{false}; // the swap is scheduled or given up, the promise is set once
+  std::promise<void> promise;
+
+  ~ElementSwap()
+  {
+    if(timeoutId)
+    {
+      gst_clock_id_unschedule(timeoutId);
+      gst_clock_id_unref(timeoutId);
+    }
+  }
+};
+using ElementSwapSPtr = std::shared_ptr<ElementSwap>;
+
+void deleteElementSwap(gpointer userData)
+{
+  delete static_cast<ElementSwapSPtr*>(userData);
+}
+
+void performSwap(ElementSwap& swap)
+{
+  gulong blockProbeId;
+  gulong eosProbeId;
+  {
+    std::lock_guard lock(swap.mutex);
+    blockProbeId = swap.blockProbeId;
+    eosProbeId = swap.eosProbeId;
+  }
+
+  gst_element_set_state(swap.oldElement.get(), GST_STATE_NULL);
+  gst_pad_unlink(swap.upstreamPad.get(), swap.oldSinkPad.get());
+  gst_pad_unlink(swap.oldSrcPad.get(), swap.downstreamPad.get());
+  // after unlinking, an EOS that is still under way after the drain timeout does not end the stream
+  gst_pad_remove_probe(swap.oldSrcPad.get(), eosProbeId);
+  gst_bin_remove(swap.bin.get(), swap.oldElement.get());
+
+  std::string error;
+  // gst_bin_add: transfer: full
+  auto* newElement = GST_ELEMENT(gst_object_ref(GST_OBJECT(swap.newElement.get())));
+  if(gst_bin_add(swap.bin.get(), newElement) == FALSE)
+  {
+    gst_object_unref(newElement);
+    error = "failed to add the new element";
+  }
+  else if(
+    gst_pad_link(swap.upstreamPad.get(), swap.newSinkPad.get()) != GST_PAD_LINK_OK
+    || gst_pad_link(swap.newSrcPad.get(), swap.downstreamPad.get()) != GST_PAD_LINK_OK
+  )
+  {
+    error = "failed to link the new element";
+  }
+  else if(gst_element_sync_state_with_parent(newElement) == FALSE)
+  {
+    error = "failed to sync the state of the new element";
+  }
+
+  // unblock even on errors, the pipeline reports not-linked then instead of stalling
+  gst_pad_remove_probe(swap.upstreamPad.get(), blockProbeId);
+
+  if(error.empty())
+  {
+    swap.promise.set_value();
+  }
+  else
+  {
+    swap.promise.set_exception(std::make_exception_ptr(std::runtime_error("Bin::replaceElement: " + error)));
+  }
+}
+
+void scheduleSwap(const ElementSwapSPtr& swap)
+{
+  {
+    std::lock_guard lock(swap->mutex);
+    if(swap->finished)
+    {
+      return;
+    }
+    swap->finished = true;
+  }
+  // the bin must not be changed from a streaming thread
+  gst_element_call_async(
+    GST_ELEMENT_CAST(swap->bin.get()),
+    [](GstElement* /*element*/, gpointer userData)
+    {
+      performSwap(**static_cast<ElementSwapSPtr*>(userData));
+    },
+    new ElementSwapSPtr(swap),
+    deleteElementSwap
+  );
+}
+
+GstPadProbeReturn onOldSrcEvent(GstPad* /*pad*/, GstPadProbeInfo* info, gpointer userData)
+{
+  if(GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) != GST_EVENT_EOS)
+  {
+    return GST_PAD_PROBE_OK;
+  }
+  scheduleSwap(*static_cast<ElementSwapSPtr*>(userData));
+  return GST_PAD_PROBE_DROP; // the old element is drained, the stream does not end downstream
+}
+
+GstPadProbeReturn onUpstreamIdle(GstPad* /*pad*/, GstPadProbeInfo* info, gpointer userData)
+{
+  const auto& swap = *static_cast<ElementSwapSPtr*>(userData);
+  {
+    std::lock_guard lock(swap->mutex);
+    if(swap->blocked)
+    {
+      return GST_PAD_PROBE_OK;
+    }
+    if(swap->finished)
+    {
+      // given up after the timeout
+      return GST_PAD_PROBE_REMOVE;
+    }
+    swap->blocked = true;
+    swap->blockProbeId = GST_PAD_PROBE_INFO_ID(info);
+    swap->eosProbeId = gst_pad_add_probe(
+      swap->oldSrcPad.get(),
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      onOldSrcEvent,
+      new ElementSwapSPtr(swap),
+      deleteElementSwap
+    );
+  }
+  // without the lock, the EOS can reach onOldSrcEvent in this thread
+  if(gst_pad_send_event(swap->oldSinkPad.get(), gst_event_new_eos()) == FALSE)
+  {
+    // not streaming, there is nothing to drain
+    scheduleSwap(swap);
+  }
+  return GST_PAD_PROBE_OK; // stay blocked until the new element is linked
+}
+
+gboolean onSwapTimeout(GstClock* /*clock*/, GstClockTime /*time*/, GstClockID /*id*/, gpointer userData)
+{
+  // weak, the ElementSwap owns the clock id
+  const auto swap = static_cast<std::weak_ptr<ElementSwap>*>(userData)->lock();
+  if(! swap)
+  {
+    return TRUE;
+  }
+  bool blocked;
+  gulong blockProbeId;
+  {
+    std::lock_guard lock(swap->mutex);
+    if(swap->finished)
+    {
+      return TRUE;
+    }
+    blocked = swap->blocked;
+    blockProbeId = swap->blockProbeId;
+    if(! blocked)
+    {
+      swap->finished = true; // given up, onUpstreamIdle removes its probe if it still runs
+    }
+  }
+  if(blocked)
+  {
+    GST_WARNING_OBJECT(swap->oldElement.get(), "not drained within the timeout, replaced without draining");
+    scheduleSwap(swap);
+    return TRUE;
+  }
+  // data is stuck upstream, e.g. a prerolled sink in PAUSED, the element can not be replaced safely
+  gst_pad_remove_probe(swap->upstreamPad.get(), blockProbeId);
+  swap->promise.set_exception(std::make_exception_ptr(
+    std::runtime_error("Bin::replaceElement: the upstream pad did not become idle within the timeout")
+  ));
+  return TRUE;
+}
+
+/**
+ * @brief Elements of a bin and its child bins by name, attached to the GstBin as qdata.
+ * Names are only unique among siblings, so a name can belong to several elements in different child bins.
+ */
+class NameIndex
+{
+public:
+  static GQuark quark()
+  {
+    static const GQuark nameIndexQuark = g_quark_from_static_string("dh-gst-bin-name-index");
+    return nameIndexQuark;
+  }
+
+  static NameIndex* get(const GstBin* bin)
+  {
+    return static_cast<NameIndex*>(g_object_get_qdata(G_OBJECT(const_cast<GstBin*>(bin)), quark()));
+  }
+
+  /**
+   * @brief adds the element if it is (still) a descendant of the bin
+   */
+  void insert(GstBin* bin, GstElement* element)
+  {
+    std::lock_guard lock(mutex);
+    if(gst_object_has_as_ancestor(GST_OBJECT_CAST(element), GST_OBJECT_CAST(bin)) == FALSE)
+    {
+      return;
+    }
+    auto& entries = elements[GST_OBJECT_NAME(element)];
+    for(const auto& entry : entries)
+    {
+      if(entry.element == element)
+      {
+        return;
+      }
+    }
+    entries.push_back({element, Element::create(element, TransferType::None)});
+  }
+
+  void erase(GstElement* element)
+  {
+    std::lock_guard lock(mutex);
+    const auto it = elements.find(GST_OBJECT_NAME(element));
+    if(it == elements.end())
+    {
+      return;
+    }
+    auto& entries = it->second;
+    for(auto entry = entries.begin(); entry != entries.end(); ++entry)
+    {
+      if(entry->element == element)
+      {
+        entries.erase(entry);
+        break;
+      }
+    }
+    if(entries.empty())
+    {
+      elements.erase(it);
+    }
+  }
+
+  /**
+   * @return the cached element or nullptr
+   */
+  std::shared_ptr<Element> find(GstBin* bin, const std::string& name) const
+  {
+    std::unique_lock lock(mutex);
+    const auto it = elements.find(name);
+    if(it == elements.end())
+    {
+      return nullptr;
+    }
+    if(it->second.size() == 1)
+    {
+      return it->second.front().wrapper;
+    }
+
+    // the name is used in several child bins, let GStreamer decide which one is found first
+    const auto candidates = it->second;
+    lock.unlock();
+    // gst_bin_get_by_name: transfer:full, nullable
+    const auto found = makeGstSharedPtr(gst_bin_get_by_name(bin, name.c_str()), TransferType::Full);
+    for(const auto& candidate : candidates)
+    {
+      if(candidate.element == found.get())
+      {
+        return candidate.wrapper;
+      }
+    }
+    return found ? Element::create(found) : nullptr;
+  }
+
+  static void onElementAdded(GstBin* bin, GstElement* element, gpointer index)
+  {
+    static_cast<NameIndex*>(index)->insert(bin, element);
+  }
+
+  static void onElementRemoved(GstBin* /*bin*/, GstElement* element, gpointer index)
+  {
+    static_cast<NameIndex*>(index)->erase(element);
+  }
+
+  static void onDeepElementAdded(GstBin* bin, GstBin* /*subBin*/, GstElement* element, gpointer index)
+  {
+    static_cast<NameIndex*>(index)->insert(bin, element);
+  }
+
+  static void onDeepElementRemoved(GstBin* /*bin*/, GstBin* /*subBin*/, GstElement* element, gpointer index)
+  {
+    static_cast<NameIndex*>(index)->erase(element);
+  }
+
+private:
+  struct Entry
+  {
+    GstElement* element; // owned by wrapper
+    std::shared_ptr<Element> wrapper;
+  };
+
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, std::vector<Entry>> elements;
+};
+
+/**
+ * @brief finds an element in the bin and its child bins, with the name index if the bin has one
+ * @return the element or nullptr
+ */
+std::shared_ptr<Element> findElementByName(GstBin* bin, const std::string& name)
+{
+  if(const auto* index = NameIndex::get(bin))
+  {
+    return index->find(bin, name);
+  }
+  // gst_bin_get_by_name: transfer:full, nullable
+  GstElement* gstElement = gst_bin_get_by_name(bin, name.c_str());
+  return gstElement ? Element::create(gstElement, TransferType::Full) : nullptr;
+}
+} // namespace
+
 Bin::Bin(GstBinSPtr gstBin)
 : Element(GST_ELEMENT_CAST(gstBin.get()), TransferType::None)
 {
@@ -111,29 +462,70 @@ void Bin::addElement(std::shared_ptr<Element> element)
   addElement(element->getGstElement());
 }
 
-std::shared_ptr<Element> Bin::getElementByName(const std::string& name)
+void Bin::enableNameIndex()
 {
-  // gst_bin_get_by_name: transfer:full, nullable
-  GstElement* gstElement = gst_bin_get_by_name(GST_BIN(getRawGstBin()), name.c_str());
-  if(!gstElement)
+  // serializes concurrent calls for the same GstBin
+  static std::mutex enableMutex;
+  std::lock_guard lock(enableMutex);
+
+  GstBin* bin = getRawGstBin();
+  if(NameIndex::get(bin))
   {
-    throw std::runtime_error("Element with name '" + name + "' not found.");
+    return;
   }
+  auto* index = new NameIndex();
+  g_object_set_qdata_full(
+    G_OBJECT(bin),
+    NameIndex::quark(),
+    index,
+    [](gpointer data)
+    {
+      delete static_cast<NameIndex*>(data);
+    }
+  );
+  // the handlers are disconnected when the GstBin is disposed, before the qdata is freed
+  g_signal_connect(bin, "element-added", G_CALLBACK(&NameIndex::onElementAdded), index);
+  g_signal_connect(bin, "element-removed", G_CALLBACK(&NameIndex::onElementRemoved), index);
+  g_signal_connect(bin, "deep-element-added", G_CALLBACK(&NameIndex::onDeepElementAdded), index);
+  g_signal_connect(bin, "deep-element-removed", G_CALLBACK(&NameIndex::onDeepElementRemoved), index);
 
-  return Element::create(gstElement, TransferType::Full);
+  // elements added meanwhile are inserted only once
+  for(const auto& element : iterateRecurse())
+  {
+    index->insert(bin, element.get());
+  }
 }
 
-std::shared_ptr<Element> Bin::getElementByNameRecurseUp(const std::string& name)
+bool Bin::hasNameIndex() const
 {
-  // gst_bin_get_by_name_recurse_up: transfer:full, nullable
+  return NameIndex::get(getRawGstBin()) != nullptr;
+}
 
-  GstElement* gstElement = gst_bin_get_by_name_recurse_up(GST_BIN(getRawGstBin()), name.c_str());
-  if (!gstElement)
+std::shared_ptr<Element> Bin::getElementByName(const std::string& name)
+{
+  auto element = findElementByName(getRawGstBin(), name);
+  if(! element)
   {
     throw std::runtime_error("Element with name '" + name + "' not found.");
   }
+  return element;
+}
 
-  return Element::create(gstElement, TransferType::Full);
+std::shared_ptr<Element> Bin::getElementByNameRecurseUp(const std::string& name)
+{
+  // like gst_bin_get_by_name_recurse_up, but every level can use its name index
+  auto bin = makeGstSharedPtr(getRawGstBin(), TransferType::None);
+  while(bin)
+  {
+    if(auto element = findElementByName(bin.get(), name))
+    {
+      return element;
+    }
+    // gst_object_get_parent: transfer:full, nullable
+    const auto parent = makeGstSharedPtr(gst_object_get_parent(GST_OBJECT_CAST(bin.get())), TransferType::Full);
+    bin = (parent && GST_IS_BIN(parent.get())) ? makeGstSharedPtr(GST_BIN_CAST(parent.get()), TransferType::None) : nullptr;
+  }
+  throw std::runtime_error("Element with name '" + name + "' not found.");
 }
 
 void Bin::removeElement(GstElementSPtr element)
@@ -152,11 +544,135 @@ void Bin::removeElement(const std::shared_ptr<Element>& element)
   }
 }
 
+ElementRange Bin::iterateElements()
+{
+  return ElementRange(gst_bin_iterate_elements(getRawGstBin()));
+}
+
+ElementRange Bin::iterateRecurse()
+{
+  return ElementRange(gst_bin_iterate_recurse(getRawGstBin()));
+}
+
+ElementRange Bin::iterateSorted()
+{
+  return ElementRange(gst_bin_iterate_sorted(getRawGstBin()));
+}
+
+ElementRange Bin::iterateSinks()
+{
+  return ElementRange(gst_bin_iterate_sinks(getRawGstBin()));
+}
+
+ElementRange Bin::iterateSources()
+{
+  return ElementRange(gst_bin_iterate_sources(getRawGstBin()));
+}
+
+std::future<void> Bin::replaceElement(GstElementSPtr oldElement, GstElementSPtr newElement, GstClockTime drainTimeout)
+{
+  if(! oldElement || ! newElement)
+  {
+    throw std::invalid_argument("Bin::replaceElement: element missing");
+  }
+  if(gst_object_has_as_parent(GST_OBJECT_CAST(oldElement.get()), GST_OBJECT_CAST(getRawGstBin())) == FALSE)
+  {
+    throw std::invalid_argument("Bin::replaceElement: old element is not a child of this bin");
+  }
+  if(GST_OBJECT_PARENT(newElement.get()) != nullptr)
+  {
+    throw std::invalid_argument("Bin::replaceElement: new element already has a parent");
+  }
+
+  auto swap = std::make_shared<ElementSwap>();
+  swap->bin = getGstBin();
+  swap->oldSinkPad = getSinglePad(oldElement.get(), GST_PAD_SINK);
+  swap->oldSrcPad = getSinglePad(oldElement.get(), GST_PAD_SRC);
+  swap->newSinkPad = getSinglePad(newElement.get(), GST_PAD_SINK);
+  swap->newSrcPad = getSinglePad(newElement.get(), GST_PAD_SRC);
+  if(! swap->oldSinkPad || ! swap->oldSrcPad || ! swap->newSinkPad || ! swap->newSrcPad)
+  {
+    throw std::invalid_argument("Bin::replaceElement: elements need exactly one sink and one src pad");
+  }
+
+  // gst_pad_get_peer: transfer: full, nullable
+  swap->upstreamPad = makeGstSharedPtr(gst_pad_get_peer(swap->oldSinkPad.get()), TransferType::Full);
+  swap->downstreamPad = makeGstSharedPtr(gst_pad_get_peer(swap->oldSrcPad.get()), TransferType::Full);
+  if(! swap->upstreamPad || ! swap->downstreamPad)
+  {
+    throw std::invalid_argument("Bin::replaceElement: old element is not linked");
+  }
+  swap->oldElement = std::move(oldElement);
+  swap->newElement = std::move(newElement);
+
+  auto future = swap->promise.get_future();
+  // may call onUpstreamIdle right away if no data is flowing
+  const gulong blockProbeId = gst_pad_add_probe(
+    swap->upstreamPad.get(),
+    GST_PAD_PROBE_TYPE_IDLE,
+    onUpstreamIdle,
+    new ElementSwapSPtr(swap),
+    deleteElementSwap
+  );
+  {
+    std::lock_guard lock(swap->mutex);
+    if(swap->finished || ! GST_CLOCK_TIME_IS_VALID(drainTimeout))
+    {
+      return future;
+    }
+    swap->blockProbeId = blockProbeId;
+  }
+
+  // gst_system_clock_obtain: transfer full
+  const auto clock = makeGstSharedPtr(gst_system_clock_obtain(), TransferType::Full);
+  swap->timeoutId = gst_clock_new_single_shot_id(clock.get(), gst_clock_get_time(clock.get()) + drainTimeout);
+  gst_clock_id_wait_async(
+    swap->timeoutId,
+    onSwapTimeout,
+    new std::weak_ptr<ElementSwap>(swap),
+    [](gpointer data){ delete static_cast<std::weak_ptr<ElementSwap>*>(data); }
+  );
+  return future;
+}
+
+std::future<void> Bin::replaceElement(
+  const std::shared_ptr<Element>& oldElement,
+  const std::shared_ptr<Element>& newElement,
+  GstClockTime drainTimeout
+)
+{
+  if(! oldElement || ! newElement)
+  {
+    throw std::invalid_argument("Bin::replaceElement: element missing");
+  }
+  return replaceElement(oldElement->getGstElement(), newElement->getGstElement(), drainTimeout);
+}
+
+bool Bin::recalculateLatency()
+{
+  return gst_bin_recalculate_latency(getRawGstBin()) == TRUE;
+}
+
 bs2::signal<void(GstElementSPtr)>& Bin::elementAddedSignal() const
 {
   return connectGobjectSignal<GstElementSPtr>("element-added");
 }
 
+bs2::signal<void(GstElementSPtr)>& Bin::elementRemovedSignal() const
+{
+  return connectGobjectSignal<GstElementSPtr>("element-removed");
+}
+
+bs2::signal<void(GstBinSPtr, GstElementSPtr)>& Bin::deepElementAddedSignal() const
+{
+  return connectGobjectSignal<GstBinSPtr, GstElementSPtr>("deep-element-added");
+}
+
+bs2::signal<void(GstBinSPtr, GstElementSPtr)>& Bin::deepElementRemovedSignal() const
+{
+  return connectGobjectSignal<GstBinSPtr, GstElementSPtr>("deep-element-removed");
+}
+
 const GstBin* Bin::getRawGstBin() const
 {
   return GST_BIN_CAST(getRawGstObject());
@@ -91,6 +91,20 @@ public:
   */
   [[nodiscard]] std::shared_ptr<Element> getElementByName(const std::string& name);
 
+  /**
+   * @brief Maintains an index of the elements in this bin and its child bins by name.
+   * With the index, @ref getElementByName and @ref getElementByNameRecurseUp do not scan the bin and
+   * return the same cached Element object for each lookup.
+   * The index follows the element-added/removed and deep-element-added/removed signals and is attached to
+   * the GstBin, so all Bin objects wrapping it use it. Enabling it again has no effect.
+   */
+  void enableNameIndex();
+
+  /**
+   * @brief whether @ref enableNameIndex was called for the GstBin
+   */
+  [[nodiscard]] bool hasNameIndex() const;
+
   /**
    * @brief Retrieves an element by its name. If the element is not found, a recursion is performed on the parent bin.
    * @param name
@@ -114,11 +128,84 @@ public:
    */
   void removeElement(const std::shared_ptr<Element>& element);
 
+  /**
+   * @brief Lazily iterates the direct children of the bin without building a container.
+   * @return single pass range of referenced elements
+   */
+  [[nodiscard]] ElementRange iterateElements();
+
+  /**
+   * @brief Lazily iterates all elements of the bin and its child bins, see @ref iterateElements
+   */
+  [[nodiscard]] ElementRange iterateRecurse();
+
+  /**
+   * @brief Lazily iterates the children in topological order, sinks first, see @ref iterateElements
+   */
+  [[nodiscard]] ElementRange iterateSorted();
+
+  /**
+   * @brief Lazily iterates the children flagged as sinks, see @ref iterateElements
+   */
+  [[nodiscard]] ElementRange iterateSinks();
+
+  /**
+   * @brief Lazily iterates the children flagged as sources, see @ref iterateElements
+   */
+  [[nodiscard]] ElementRange iterateSources();
+
+  /**
+   * @brief Replaces a linked child element while the bin keeps running.
+   * The upstream pad is blocked with an idle probe, the old element is drained with EOS, then it is
+   * unlinked and removed, the new element is added and linked in its place, synced to the state of
+   * the bin and the upstream pad is unblocked. If the old element does not accept the EOS (e.g. the bin
+   * is not running), it is replaced without draining.
+   * If the EOS does not come out of the old element within drainTimeout (e.g. it holds the EOS back),
+   * it is replaced without draining and the data still inside it is lost. If the upstream pad does not
+   * become idle within drainTimeout (e.g. a prerolled sink blocks the streaming thread in PAUSED),
+   * the replacement is given up and the bin is not changed.
+   * Both elements must have exactly one sink and one src pad.
+   * @param oldElement a child of this bin which is linked upstream and downstream
+   * @param newElement the replacement, must not have a parent
+   * @param drainTimeout the maximum time to wait for the idle upstream pad and for the drain,
+   * GST_CLOCK_TIME_NONE to wait without limit
+   * @return future which is ready when the new element is linked, holds a std::runtime_error if that failed
+   * @throws std::invalid_argument if the elements do not fulfill the requirements above
+   */
+  std::future<void> replaceElement(GstElementSPtr oldElement, GstElementSPtr newElement, GstClockTime drainTimeout = GST_SECOND);
+
+  /**
+   * @brief Replaces a linked child element while the bin keeps running.
+   * See @ref replaceElement(GstElementSPtr, GstElementSPtr, GstClockTime)
+   */
+  std::future<void> replaceElement(
+    const std::shared_ptr<Element>& oldElement,
+    const std::shared_ptr<Element>& newElement,
+    GstClockTime drainTimeout = GST_SECOND
+  );
+
+  /**
+   * @brief Query the latencies of the sinks and distribute the new latency to all elements.
+   * Call it when a LATENCY message was received. Not from a streaming thread (e.g. a bus sync handler).
+   * @return true if the latency could be queried and set
+   */
+  bool recalculateLatency();
+
   [[nodiscard]] bs2::signal<void(GstElementSPtr)>& elementAddedSignal() const;
+  [[nodiscard]] bs2::signal<void(GstElementSPtr)>& elementRemovedSignal() const;
+
+  /**
+   * @brief emitted when an element was added to a child bin (at any depth)
+   * signature: void(GstBinSPtr subBin, GstElementSPtr element)
+   */
+  [[nodiscard]] bs2::signal<void(GstBinSPtr, GstElementSPtr)>& deepElementAddedSignal() const;
+
+  /**
+   * @brief emitted when an element was removed from a child bin (at any depth)
+   * signature: void(GstBinSPtr subBin, GstElementSPtr element)
+   */
+  [[nodiscard]] bs2::signal<void(GstBinSPtr, GstElementSPtr)>& deepElementRemovedSignal() const;
  /* TODO: add signals
-  * element-removed
-  * deep-element-added
-  * deep-element-removed
   * do-latency
   */
 
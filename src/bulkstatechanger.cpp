@@ -0,0 +1,195 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "bulkstatechanger.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace dh::gst
+{
+
+namespace
+{
+/**
+ * @brief the results of one setState call, completed by the last pipeline
+ */
+struct Batch
+{
+  std::vector<BulkStateChanger::Result> results;
+  std::atomic<std::size_t> remaining{0};
+  std::promise<std::vector<BulkStateChanger::Result>> promise;
+  BulkStateChanger::ResultCallback onResult;
+
+  void complete(std::size_t index, GstStateChangeReturn result, GstClockTime started)
+  {
+    auto& entry = results[index];
+    entry.result = result;
+    entry.duration = GST_CLOCK_DIFF(started, gst_util_get_timestamp());
+    if(onResult)
+    {
+      try
+      {
+        onResult(entry);
+      }
+      catch(const std::exception& e)
+      {
+        GST_ERROR("BulkStateChanger: result callback threw: %s", e.what());
+      }
+    }
+    // each entry is written by one thread only, the last one publishes all of them
+    if(remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      promise.set_value(std::move(results));
+    }
+  }
+};
+} // namespace
+
+class BulkStateChanger::Private
+{
+public:
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::function<void()>> tasks;
+  bool running{true};
+  std::vector<std::thread> workers;
+
+  void run()
+  {
+    std::unique_lock lock(mutex);
+    while(true)
+    {
+      condition.wait(lock, [this]{ return ! running || ! tasks.empty(); });
+      if(tasks.empty())
+      {
+        return;
+      }
+      auto task = std::move(tasks.front());
+      tasks.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  }
+};
+
+BulkStateChanger::BulkStateChanger(std::size_t workerCount)
+: prv{std::make_shared<Private>()}
+{
+  if(workerCount == 0)
+  {
+    workerCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for(std::size_t i = 0; i < workerCount; ++i)
+  {
+    prv->workers.emplace_back([prv = prv]{ prv->run(); });
+  }
+}
+
+BulkStateChanger::~BulkStateChanger()
+{
+  {
+    std::lock_guard lock(prv->mutex);
+    prv->running = false;
+  }
+  prv->condition.notify_all();
+  for(auto& worker : prv->workers)
+  {
+    worker.join();
+  }
+}
+
+std::shared_ptr<BulkStateChanger> BulkStateChanger::create(std::size_t workerCount)
+{
+  return std::shared_ptr<BulkStateChanger>(new BulkStateChanger(workerCount));
+}
+
+std::future<std::vector<BulkStateChanger::Result>> BulkStateChanger::setState(
+  const std::vector<std::shared_ptr<Pipeline>>& pipelines,
+  GstState state,
+  GstClockTime timeout,
+  ResultCallback onResult
+)
+{
+  auto batch = std::make_shared<Batch>();
+  batch->onResult = std::move(onResult);
+  batch->results.reserve(pipelines.size());
+  for(const auto& pipeline : pipelines)
+  {
+    if(! pipeline)
+    {
+      throw std::invalid_argument("BulkStateChanger: pipeline is nullptr");
+    }
+    batch->results.push_back({pipeline, GST_STATE_CHANGE_ASYNC, GST_CLOCK_TIME_NONE});
+  }
+  auto future = batch->promise.get_future();
+  if(pipelines.empty())
+  {
+    batch->promise.set_value({});
+    return future;
+  }
+  batch->remaining = pipelines.size();
+
+  {
+    std::lock_guard lock(prv->mutex);
+    for(std::size_t index = 0; index < pipelines.size(); ++index)
+    {
+      prv->tasks.emplace_back(
+        [batch, index, state, timeout, pipeline = pipelines[index]]()
+        {
+          const GstClockTime started = gst_util_get_timestamp();
+          try
+          {
+            pipeline->setStateAsync(
+              state,
+              [batch, index, started](GstStateChangeReturn result)
+              {
+                batch->complete(index, result, started);
+              },
+              timeout
+            );
+          }
+          catch(const std::exception& e)
+          {
+            GST_ERROR("BulkStateChanger: state change of '%s' threw: %s", pipeline->getName().c_str(), e.what());
+            batch->complete(index, GST_STATE_CHANGE_FAILURE, started);
+          }
+        }
+      );
+    }
+  }
+  prv->condition.notify_all();
+  return future;
+}
+
+std::size_t BulkStateChanger::getWorkerCount() const
+{
+  return prv->workers.size();
+}
+
+} // dh::gst
@@ -0,0 +1,99 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_BULKSTATECHANGER_HPP
+#define DH_GST_BULKSTATECHANGER_HPP
+
+// local includes
+#include "pipeline.hpp"
+
+// std
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+// C
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Changes the state of many pipelines concurrently.
+ * The blocking part of a state change (e.g. opening devices in NULL->READY) runs on a pool of worker threads,
+ * ASYNC transitions are completed with @ref Element::setStateAsync and don't occupy a worker.
+ * @code
+ * auto changer = BulkStateChanger::create(16);
+ * auto results = changer->setState(pipelines, GST_STATE_PLAYING, 10 * GST_SECOND).get();
+ * @endcode
+ */
+class BulkStateChanger
+{
+protected:
+  /**
+   * @brief Create the worker threads.
+   * @param workerCount number of threads, 0 for the number of hardware threads
+   */
+  explicit BulkStateChanger(std::size_t workerCount);
+
+public:
+  struct Result
+  {
+    std::shared_ptr<Pipeline> pipeline;
+    GstStateChangeReturn result;  ///< like @ref Element::setStateAsync, ASYNC on timeout
+    GstClockTime duration;        ///< from the start of the state change of this pipeline until its result
+  };
+  using ResultCallback = std::function<void(const Result& result)>;
+
+  [[nodiscard]] static std::shared_ptr<BulkStateChanger> create(std::size_t workerCount = 0);
+
+  /**
+   * @brief runs the queued state changes and waits for the workers, ASYNC transitions are not waited for.
+   */
+  ~BulkStateChanger();
+
+  /**
+   * @brief Set the state of all pipelines.
+   * @param pipelines the pipelines, must not contain nullptr
+   * @param state the target state
+   * @param timeout maximum time for each ASYNC transition, GST_CLOCK_TIME_NONE to wait forever
+   * @param onResult optional, called for each pipeline as soon as its result is known (from a worker, streaming or clock thread)
+   * @return the results in the order of pipelines, ready when all state changes have finished
+   * @throws std::invalid_argument if a pipeline is nullptr
+   */
+  [[nodiscard]] std::future<std::vector<Result>> setState(
+    const std::vector<std::shared_ptr<Pipeline>>& pipelines,
+    GstState state,
+    GstClockTime timeout = GST_CLOCK_TIME_NONE,
+    ResultCallback onResult = {}
+  );
+
+  [[nodiscard]] std::size_t getWorkerCount() const;
+
+private:
+  class Private;
+  std::shared_ptr<Private> prv; // shared with the worker threads
+};
+
+} // dh::gst
+
+#endif //DH_GST_BULKSTATECHANGER_HPP
@@ -20,6 +20,9 @@
 
 #include "bus.hpp"
 
+// std
+#include <stdexcept>
+
 namespace dh::gst
 {
 
@@ -64,6 +67,46 @@ void Bus::post(const GstMessageSPtr message)
   gst_bus_post(getRawGstBus(), gst_message_ref(message.get()));
 }
 
+GstMessageSPtr Bus::timedPopFiltered(GstClockTime timeout, GstMessageType types)
+{
+  // gst_bus_timed_pop_filtered: transfer full, nullable
+  return makeGstSharedPtr(gst_bus_timed_pop_filtered(getRawGstBus(), timeout, types), TransferType::Full);
+}
+
+GstMessageSPtr Bus::pop()
+{
+  // gst_bus_pop: transfer full, nullable
+  return makeGstSharedPtr(gst_bus_pop(getRawGstBus()), TransferType::Full);
+}
+
+std::size_t Bus::drain(const MessageHandler& handler, std::size_t maxMessages, GstMessageType types)
+{
+  std::size_t count{0};
+  while(maxMessages == 0 || count < maxMessages)
+  {
+    // gst_bus_pop_filtered: transfer full, nullable
+    auto message = makeGstSharedPtr(gst_bus_pop_filtered(getRawGstBus(), types), TransferType::Full);
+    if(! message)
+    {
+      break;
+    }
+    ++count;
+    handler(std::move(message));
+  }
+  return count;
+}
+
+int Bus::getPollFd() const
+{
+  GPollFD pollFd{-1, 0, 0};
+  gst_bus_get_pollfd(const_cast<GstBus*>(getRawGstBus()), &pollFd);
+  if(pollFd.fd < 0)
+  {
+    throw std::runtime_error("Bus has no pollable file descriptor");
+  }
+  return pollFd.fd;
+}
+
 bs2::signal<void(GstMessageSPtr)>& Bus::newSyncMessageSignal() const
 {
   //TODO: on disconnect, gst_bus_enable_sync_message_emission should be called as often as it was enabled to stop sync signal emission
@@ -27,6 +27,10 @@
 // boost
 #include <boost/signals2.hpp>
 
+// std
+#include <cstddef>
+#include <functional>
+
 namespace bs2 = boost::signals2;
 
 namespace dh::gst
@@ -65,6 +69,43 @@ public:
    */
   void post(const GstMessageSPtr message);
 
+  /**
+   * @brief Get a message from the bus whose type matches the message type mask.
+   * Messages that do not match are removed from the bus and dropped.
+   * @param timeout how long to wait for a message, GST_CLOCK_TIME_NONE to wait forever, 0 to not wait
+   * @param types the message types to return
+   * @return the message or an empty ptr if the timeout expired
+   */
+  [[nodiscard]] GstMessageSPtr timedPopFiltered(GstClockTime timeout, GstMessageType types);
+
+  /**
+   * @brief Get a message from the bus without waiting.
+   * @return the message or an empty ptr if there is no pending message
+   */
+  [[nodiscard]] GstMessageSPtr pop();
+
+  using MessageHandler = std::function<void(GstMessageSPtr)>;
+
+  /**
+   * @brief Pop pending messages without waiting and call handler for each of them.
+   * Use this together with @ref getPollFd to service many buses from one thread.
+   * @param handler called for every popped message
+   * @param maxMessages stop after this number of messages (0: until the bus is empty), to be fair to other buses
+   * @param types only messages of these types are handled, other messages are dropped
+   * @return the number of handled messages
+   */
+  std::size_t drain(const MessageHandler& handler, std::size_t maxMessages = 0, GstMessageType types = GST_MESSAGE_ANY);
+
+  /**
+   * @brief Get the file descriptor that becomes readable while messages are pending on the bus.
+   * The descriptor can be added to epoll/poll/select or any other reactor (level triggered).
+   * Never read from it, use @ref pop or @ref drain instead.
+   * Only one reactor should wait on the descriptor of a bus.
+   * @return the file descriptor
+   * @throws std::runtime_error if the bus has no pollable descriptor
+   */
+  [[nodiscard]] int getPollFd() const;
+
   /**
    * @brief  A message has been posted on the bus.
    * This signal is emitted from the thread that posted the message so one has to be careful with locking.
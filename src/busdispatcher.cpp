@@ -0,0 +1,353 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "busdispatcher.hpp"
+#include "helpers.hpp"
+
+// std
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace dh::gst
+{
+
+namespace
+{
+constexpr const char* wakeUpMessageName = "dh-gst-bus-dispatcher-wakeup";
+} // namespace
+
+class BusDispatcher::Private : public std::enable_shared_from_this<BusDispatcher::Private>
+{
+public:
+  struct Subscription
+  {
+    GstMessageType messageTypes;
+    std::function<GstMessageType()> messageTypesGetter; // for subscriptions with changing types
+    bs2::scoped_connection messageTypesConnection;     // reports changes of messageTypesGetter
+    bs2::signal<void(GstMessageSPtr)> signal;
+
+    GstMessageType getMessageTypes() const
+    {
+      return messageTypesGetter ? messageTypesGetter() : messageTypes;
+    }
+  };
+  using Subscriptions = std::vector<std::shared_ptr<Subscription>>;
+
+  explicit Private(std::shared_ptr<Bus> bus)
+  : bus{std::move(bus)}
+  {
+    // wait on the descriptor of the bus and on the poll itself, which is set flushing to stop the thread
+    busPollFd.fd = this->bus->getPollFd();
+    poll = gst_poll_new(TRUE);
+    if(! poll)
+    {
+      throw std::runtime_error("BusDispatcher: failed to create a poll");
+    }
+    gst_poll_add_fd(poll, &busPollFd);
+    gst_poll_fd_ctl_read(poll, &busPollFd, TRUE);
+  }
+
+  Private(const Private&) = delete;
+  Private& operator=(const Private&) = delete;
+
+  ~Private()
+  {
+    gst_poll_free(poll);
+  }
+
+  std::shared_ptr<Bus> bus;
+  GstPoll* poll{nullptr};
+  GstPollFD busPollFd = GST_POLL_FD_INIT;
+
+  mutable std::mutex mutex;
+  // copy on write, so the dispatcher thread can iterate without holding the lock
+  std::shared_ptr<const Subscriptions> subscriptions{std::make_shared<Subscriptions>()};
+
+  std::mutex threadMutex;
+  std::thread thread;
+  std::atomic<bool> running{false};
+  std::atomic<unsigned> generation{0}; // lets an old thread (stopped from a slot) end after a restart
+
+  std::shared_ptr<const Subscriptions> getSubscriptions() const
+  {
+    std::lock_guard lock(mutex);
+    return subscriptions;
+  }
+
+  static GstMessageType computeMask(const Subscriptions& subscriptions)
+  {
+    guint mask = GST_MESSAGE_UNKNOWN;
+    for(const auto& subscription : subscriptions)
+    {
+      if(! subscription->signal.empty())
+      {
+        mask |= subscription->getMessageTypes();
+      }
+    }
+    return static_cast<GstMessageType>(mask);
+  }
+
+  /**
+   * @brief Let the dispatcher thread compute the mask again before it pops the next message.
+   * The wake up is queued behind the messages already on the bus, so these are still filtered with the old mask,
+   * but all messages posted after a subscription was added are popped with the new mask.
+   */
+  void postWakeUp()
+  {
+    if(! running)
+    {
+      // the thread computes the mask when it starts
+      return;
+    }
+    bus->post(
+      makeGstSharedPtr(
+        gst_message_new_application(nullptr, gst_structure_new_empty(wakeUpMessageName)),
+        TransferType::Full
+      )
+    );
+  }
+
+  bs2::connection addSubscription(std::shared_ptr<Subscription> subscription, const MessageSlot& slot)
+  {
+    // boost::signals2 releases the slot when it is disconnected, the guard in the wrapper shrinks the mask then
+    std::shared_ptr<void> guard(
+      nullptr,
+      [weakSelf = weak_from_this()](void*)
+      {
+        if(const auto self = weakSelf.lock())
+        {
+          self->postWakeUp();
+        }
+      }
+    );
+    auto connection = subscription->signal.connect(
+      [slot, guard = std::move(guard)](GstMessageSPtr message)
+      {
+        slot(std::move(message));
+      }
+    );
+    {
+      std::lock_guard lock(mutex);
+      auto newSubscriptions = std::make_shared<Subscriptions>();
+      newSubscriptions->reserve(subscriptions->size() + 1);
+      for(const auto& existing : *subscriptions)
+      {
+        // drop disconnected subscriptions
+        if(! existing->signal.empty())
+        {
+          newSubscriptions->push_back(existing);
+        }
+      }
+      newSubscriptions->push_back(std::move(subscription));
+      subscriptions = std::move(newSubscriptions);
+    }
+    postWakeUp();
+    return connection;
+  }
+
+  static bool isWakeUp(const GstMessageSPtr& message)
+  {
+    if(GST_MESSAGE_TYPE(message.get()) != GST_MESSAGE_APPLICATION)
+    {
+      return false;
+    }
+    const GstStructure* structure = gst_message_get_structure(message.get());
+    return structure && gst_structure_has_name(structure, wakeUpMessageName);
+  }
+
+  bool isCurrent(unsigned threadGeneration) const
+  {
+    return running && generation == threadGeneration;
+  }
+
+  void run(unsigned threadGeneration)
+  {
+    // the wake up messages are popped with every mask
+    auto computePopMask = [this]{ return static_cast<GstMessageType>(computeMask(*getSubscriptions()) | GST_MESSAGE_APPLICATION); };
+    GstMessageType mask = computePopMask();
+    while(isCurrent(threadGeneration))
+    {
+      // blocks until messages are pending or stop() sets the poll flushing
+      if(gst_poll_wait(poll, GST_CLOCK_TIME_NONE) < 0)
+      {
+        continue;
+      }
+      // the bus drops the messages outside of the mask
+      while(isCurrent(threadGeneration))
+      {
+        const auto message = bus->timedPopFiltered(0, mask);
+        if(! message)
+        {
+          break;
+        }
+        if(isWakeUp(message))
+        {
+          mask = computePopMask();
+          continue;
+        }
+        dispatch(message);
+      }
+    }
+  }
+
+  void dispatch(const GstMessageSPtr& message)
+  {
+    const GstMessageType type = GST_MESSAGE_TYPE(message.get());
+    for(const auto& subscription : *getSubscriptions())
+    {
+      if(! helpers::isMessageTypeInMask(type, subscription->getMessageTypes()))
+      {
+        continue;
+      }
+      try
+      {
+        subscription->signal(message);
+      }
+      catch(const std::exception& e)
+      {
+        GST_ERROR("BusDispatcher: slot for '%s' threw: %s", GST_MESSAGE_TYPE_NAME(message.get()), e.what());
+      }
+    }
+  }
+};
+
+BusDispatcher::BusDispatcher(std::shared_ptr<Bus> bus)
+{
+  if(! bus)
+  {
+    throw std::invalid_argument("BusDispatcher: no bus given");
+  }
+  prv = std::make_shared<Private>(std::move(bus));
+}
+
+BusDispatcher::~BusDispatcher()
+{
+  stop();
+  std::lock_guard lock(prv->threadMutex);
+  if(prv->thread.joinable())
+  {
+    // destroyed from a slot: the thread keeps its own reference to prv and ends after the slot
+    prv->thread.detach();
+  }
+}
+
+std::shared_ptr<BusDispatcher> BusDispatcher::create(std::shared_ptr<Bus> bus)
+{
+  return std::shared_ptr<BusDispatcher>(new BusDispatcher(std::move(bus)));
+}
+
+bs2::connection BusDispatcher::subscribe(GstMessageType messageTypes, const MessageSlot& slot)
+{
+  auto subscription = std::make_shared<Private::Subscription>();
+  subscription->messageTypes = messageTypes;
+  return prv->addSubscription(std::move(subscription), slot);
+}
+
+bs2::connection BusDispatcher::subscribe(const std::shared_ptr<MessageParser>& parser)
+{
+  if(! parser)
+  {
+    throw std::invalid_argument("BusDispatcher: no parser given");
+  }
+  auto subscription = std::make_shared<Private::Subscription>();
+  subscription->messageTypes = GST_MESSAGE_UNKNOWN;
+  subscription->messageTypesGetter = [weakParser = std::weak_ptr<MessageParser>(parser)]()
+  {
+    const auto parser = weakParser.lock();
+    return parser ? parser->getInterestMask() : GST_MESSAGE_UNKNOWN;
+  };
+  subscription->messageTypesConnection = parser->interestMaskChangedSignal.connect(
+    [weakPrv = std::weak_ptr<Private>(prv)](GstMessageType)
+    {
+      if(const auto prv = weakPrv.lock())
+      {
+        prv->postWakeUp();
+      }
+    }
+  );
+  return prv->addSubscription(
+    std::move(subscription),
+    [weakParser = std::weak_ptr<MessageParser>(parser)](GstMessageSPtr message)
+    {
+      if(const auto parser = weakParser.lock())
+      {
+        parser->parse(*message);
+      }
+    }
+  );
+}
+
+GstMessageType BusDispatcher::getMessageMask() const
+{
+  return Private::computeMask(*prv->getSubscriptions());
+}
+
+void BusDispatcher::start()
+{
+  std::lock_guard lock(prv->threadMutex);
+  if(prv->running)
+  {
+    return;
+  }
+  if(prv->thread.joinable())
+  {
+    // stopped from a slot before, the old thread ends by itself
+    if(prv->thread.get_id() == std::this_thread::get_id())
+    {
+      prv->thread.detach();
+    }
+    else
+    {
+      prv->thread.join();
+    }
+  }
+  gst_poll_set_flushing(prv->poll, FALSE);
+  prv->running = true;
+  prv->thread = std::thread(
+    [prv = prv, threadGeneration = ++prv->generation]()
+    {
+      prv->run(threadGeneration);
+    }
+  );
+}
+
+void BusDispatcher::stop()
+{
+  std::lock_guard lock(prv->threadMutex);
+  prv->running = false;
+  // wakes up the thread without touching the bus, which can be flushing (pipeline in NULL)
+  gst_poll_set_flushing(prv->poll, TRUE);
+  if(! prv->thread.joinable() || prv->thread.get_id() == std::this_thread::get_id())
+  {
+    return;
+  }
+  prv->thread.join();
+}
+
+bool BusDispatcher::isRunning() const
+{
+  return prv->running;
+}
+
+} // dh::gst
@@ -0,0 +1,123 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_BUSDISPATCHER_HPP
+#define DH_GST_BUSDISPATCHER_HPP
+
+// local includes
+#include "bus.hpp"
+#include "messageparser.hpp"
+#include "sharedptrs.hpp"
+
+// boost
+#include <boost/signals2.hpp>
+
+// std
+#include <functional>
+#include <memory>
+
+// C
+#include <gst/gst.h>
+
+namespace bs2 = boost::signals2;
+
+namespace dh::gst
+{
+
+/**
+ * @brief Pops messages from a Bus in an own thread and dispatches them to the subscribed slots.
+ * Unlike @ref Bus::newSyncMessageSignal, the slots are not called from the streaming threads that post the messages.
+ * The thread blocks on the poll descriptor of the bus (see @ref Bus::getPollFd) until messages are pending and
+ * pops them with gst_bus_timed_pop_filtered and the mask of all subscriptions (see @ref getMessageMask).
+ * Messages of other types are dropped by the bus and never touch the slots. The mask is computed again
+ * whenever a subscription is added or disconnected or the interest mask of a subscribed parser changes.
+ * So do not use a BusDispatcher together with other consumers that pop from the same bus (e.g. a bus watch).
+ * Like for gst_bus_timed_pop_filtered, extended message types (e.g. GST_MESSAGE_STREAMS_SELECTED) only match
+ * a subscription whose types contain GST_MESSAGE_EXTENDED.
+ */
+class BusDispatcher
+{
+protected:
+  /**
+   * @brief Create a new BusDispatcher for the given Bus. The dispatcher thread is not started.
+   * @param bus the bus to pop messages from
+   * @throws std::invalid_argument if bus is empty
+   * @throws std::runtime_error if the bus has no pollable descriptor
+   */
+  explicit BusDispatcher(std::shared_ptr<Bus> bus);
+
+public:
+  using MessageSlot = std::function<void(GstMessageSPtr)>;
+
+  [[nodiscard]] static std::shared_ptr<BusDispatcher> create(std::shared_ptr<Bus> bus);
+
+  /**
+   * @brief stops the dispatcher thread and waits for it.
+   */
+  ~BusDispatcher();
+
+  /**
+   * @brief Call slot from the dispatcher thread for each message with one of the given types.
+   * The subscription is active until the returned connection is disconnected.
+   * @param messageTypes mask of the message types, e.g. GST_MESSAGE_ERROR | GST_MESSAGE_EOS
+   * @param slot the function to call
+   * @return the connection of the subscription
+   */
+  bs2::connection subscribe(GstMessageType messageTypes, const MessageSlot& slot);
+
+  /**
+   * @brief Pass messages to the parser. Only the types in its @ref MessageParser::getInterestMask are passed,
+   * so message types without connected parser slots are dropped without reaching the parser.
+   * Changes of the mask apply to the messages posted after the change (see @ref MessageParser::interestMaskChangedSignal).
+   * The dispatcher only holds a weak reference, the subscription ends when the parser is destroyed.
+   * @param parser the parser
+   * @return the connection of the subscription
+   * @throws std::invalid_argument if parser is empty
+   */
+  bs2::connection subscribe(const std::shared_ptr<MessageParser>& parser);
+
+  /**
+   * @brief Get the mask of all message types with connected subscriptions.
+   * @return the mask of the dispatched message types
+   */
+  [[nodiscard]] GstMessageType getMessageMask() const;
+
+  /**
+   * @brief Start the dispatcher thread. Does nothing if it is already running.
+   */
+  void start();
+
+  /**
+   * @brief Stop the dispatcher thread and wait until it has finished. The state of the bus is not touched,
+   * so this also works while the bus is flushing (pipeline in NULL).
+   * If called from a slot (dispatcher thread), the thread stops after the slot returns.
+   */
+  void stop();
+
+  [[nodiscard]] bool isRunning() const;
+
+private:
+  class Private;
+  std::shared_ptr<Private> prv; // shared with the dispatcher thread
+};
+
+} // dh::gst
+
+#endif //DH_GST_BUSDISPATCHER_HPP
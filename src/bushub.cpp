@@ -0,0 +1,394 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "bushub.hpp"
+#include "helpers.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace dh::gst
+{
+
+class BusHub::Private
+{
+public:
+  enum class State
+  {
+    Idle,    ///< no messages
+    Queued,  ///< in the ready queue
+    Running  ///< handled by a worker
+  };
+
+  struct Entry
+  {
+    Id id;
+    GstBusSPtr bus;
+    MessageSlot handler;
+
+    std::mutex mutex;
+    std::deque<GstMessage*> priorityMessages; // own references
+    std::deque<GstMessage*> messages;         // own references
+    State state{State::Idle};                 // written with hub and entry mutex locked
+    std::atomic<bool> removed{false};
+
+    ~Entry()
+    {
+      for(GstMessage* message : priorityMessages)
+      {
+        gst_message_unref(message);
+      }
+      for(GstMessage* message : messages)
+      {
+        gst_message_unref(message);
+      }
+    }
+
+    bool isEmpty() const
+    {
+      return priorityMessages.empty() && messages.empty();
+    }
+
+    GstMessage* pop()
+    {
+      auto& queue = priorityMessages.empty() ? messages : priorityMessages;
+      if(queue.empty())
+      {
+        return nullptr;
+      }
+      GstMessage* message = queue.front();
+      queue.pop_front();
+      return message;
+    }
+  };
+
+  struct HandlerData
+  {
+    std::shared_ptr<Private> hub;
+    std::shared_ptr<Entry> entry;
+  };
+
+  mutable std::mutex mutex;
+  std::condition_variable condition;
+  std::map<Id, std::shared_ptr<Entry>> entries;
+  std::deque<std::shared_ptr<Entry>> ready;
+  Id nextId{1};
+  bool stopping{false};
+  std::vector<std::thread> workers;
+
+  std::atomic<std::size_t> queueLimit{1000};
+  std::atomic<std::size_t> batchSize{16};
+  std::atomic<guint> priorityTypes{GST_MESSAGE_ERROR | GST_MESSAGE_EOS};
+  std::atomic<std::uint64_t> droppedCount{0};
+
+  static GstBusSyncReply onSyncMessage(GstBus* /*bus*/, GstMessage* message, gpointer userData)
+  {
+    auto* data = static_cast<HandlerData*>(userData);
+    data->hub->enqueue(data->entry, message);
+    return GST_BUS_DROP;
+  }
+
+  static void destroyHandlerData(gpointer userData)
+  {
+    delete static_cast<HandlerData*>(userData);
+  }
+
+  /**
+   * @brief add the message to the queue of the entry and schedule the entry if needed
+   * @param message transfer none
+   */
+  void enqueue(const std::shared_ptr<Entry>& entry, GstMessage* message)
+  {
+    const bool priority = helpers::isMessageTypeInMask(
+      GST_MESSAGE_TYPE(message), static_cast<GstMessageType>(priorityTypes.load(std::memory_order_relaxed)));
+    State state;
+    {
+      std::lock_guard entryLock(entry->mutex);
+      if(priority)
+      {
+        entry->priorityMessages.push_back(gst_message_ref(message));
+      }
+      else if(entry->messages.size() >= queueLimit.load(std::memory_order_relaxed))
+      {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        GST_LOG("BusHub: queue of pipeline %" G_GUINT64_FORMAT " is full, dropping '%s' message", entry->id, GST_MESSAGE_TYPE_NAME(message));
+        return;
+      }
+      else
+      {
+        entry->messages.push_back(gst_message_ref(message));
+      }
+      state = entry->state;
+    }
+
+    // a running entry is scheduled again by its worker, a queued one only moves for priority messages
+    if(state == State::Running || (state == State::Queued && ! priority))
+    {
+      return;
+    }
+
+    std::lock_guard lock(mutex);
+    if(entry->removed)
+    {
+      return;
+    }
+    std::lock_guard entryLock(entry->mutex);
+    if(entry->state == State::Idle)
+    {
+      entry->state = State::Queued;
+      if(priority)
+      {
+        ready.push_front(entry);
+      }
+      else
+      {
+        ready.push_back(entry);
+      }
+      condition.notify_one();
+    }
+    else if(entry->state == State::Queued && priority)
+    {
+      const auto it = std::find(ready.begin(), ready.end(), entry);
+      if(it != ready.end() && it != ready.begin())
+      {
+        ready.erase(it);
+        ready.push_front(entry);
+      }
+    }
+  }
+
+  void run()
+  {
+    std::unique_lock lock(mutex);
+    while(true)
+    {
+      condition.wait(lock, [this]{ return stopping || ! ready.empty(); });
+      if(stopping)
+      {
+        return;
+      }
+      auto entry = std::move(ready.front());
+      ready.pop_front();
+      {
+        std::lock_guard entryLock(entry->mutex);
+        entry->state = State::Running;
+      }
+      lock.unlock();
+
+      handleBatch(*entry);
+
+      lock.lock();
+      std::lock_guard entryLock(entry->mutex);
+      if(entry->removed || entry->isEmpty())
+      {
+        entry->state = State::Idle;
+      }
+      else
+      {
+        // round robin, unless a priority message is waiting
+        entry->state = State::Queued;
+        if(entry->priorityMessages.empty())
+        {
+          ready.push_back(entry);
+        }
+        else
+        {
+          ready.push_front(entry);
+        }
+      }
+    }
+  }
+
+  void handleBatch(Entry& entry)
+  {
+    const std::size_t maxMessages = batchSize.load(std::memory_order_relaxed);
+    for(std::size_t handled = 0; handled < maxMessages && ! entry.removed; ++handled)
+    {
+      GstMessage* message;
+      {
+        std::lock_guard entryLock(entry.mutex);
+        message = entry.pop();
+      }
+      if(! message)
+      {
+        return;
+      }
+      try
+      {
+        entry.handler(makeGstSharedPtr(message, TransferType::Full));
+      }
+      catch(const std::exception& e)
+      {
+        GST_ERROR("BusHub: handler of pipeline %" G_GUINT64_FORMAT " threw: %s", entry.id, e.what());
+      }
+    }
+  }
+
+  void detach(Entry& entry)
+  {
+    entry.removed = true;
+    // destroys the HandlerData
+    gst_bus_set_sync_handler(entry.bus.get(), nullptr, nullptr, nullptr);
+  }
+};
+
+BusHub::BusHub(std::size_t workerCount)
+: prv{std::make_shared<Private>()}
+{
+  if(workerCount == 0)
+  {
+    throw std::invalid_argument("BusHub: at least one worker is needed");
+  }
+  prv->workers.reserve(workerCount);
+  for(std::size_t i = 0; i < workerCount; ++i)
+  {
+    // the workers keep prv alive, a worker destroying the hub from a handler is detached
+    prv->workers.emplace_back([prv = prv]{ prv->run(); });
+  }
+}
+
+BusHub::~BusHub()
+{
+  std::map<Id, std::shared_ptr<Private::Entry>> entries;
+  {
+    std::lock_guard lock(prv->mutex);
+    prv->stopping = true;
+    entries.swap(prv->entries);
+    prv->ready.clear();
+  }
+  prv->condition.notify_all();
+  for(auto& worker : prv->workers)
+  {
+    if(worker.get_id() == std::this_thread::get_id())
+    {
+      // destroyed from a handler
+      worker.detach();
+    }
+    else
+    {
+      worker.join();
+    }
+  }
+  for(auto& [id, entry] : entries)
+  {
+    prv->detach(*entry);
+  }
+}
+
+std::shared_ptr<BusHub> BusHub::create(std::size_t workerCount)
+{
+  return std::shared_ptr<BusHub>(new BusHub(workerCount));
+}
+
+BusHub::Id BusHub::add(const Pipeline& pipeline, MessageSlot handler)
+{
+  if(! handler)
+  {
+    throw std::invalid_argument("BusHub: no handler given");
+  }
+  auto entry = std::make_shared<Private::Entry>();
+  entry->bus = pipeline.getBus()->getGstBus();
+  entry->handler = std::move(handler);
+  {
+    std::lock_guard lock(prv->mutex);
+    entry->id = prv->nextId++;
+    prv->entries.emplace(entry->id, entry);
+  }
+
+  gst_bus_set_sync_handler(
+    entry->bus.get(),
+    &Private::onSyncMessage,
+    new Private::HandlerData{prv, entry},
+    &Private::destroyHandlerData
+  );
+
+  // messages posted before the sync handler was installed
+  while(GstMessage* message = gst_bus_pop(entry->bus.get()))
+  {
+    prv->enqueue(entry, message);
+    gst_message_unref(message);
+  }
+  return entry->id;
+}
+
+bool BusHub::remove(Id id)
+{
+  std::shared_ptr<Private::Entry> entry;
+  {
+    std::lock_guard lock(prv->mutex);
+    const auto it = prv->entries.find(id);
+    if(it == prv->entries.end())
+    {
+      return false;
+    }
+    entry = std::move(it->second);
+    prv->entries.erase(it);
+    prv->ready.erase(std::remove(prv->ready.begin(), prv->ready.end(), entry), prv->ready.end());
+    entry->removed = true;
+  }
+  prv->detach(*entry);
+  return true;
+}
+
+void BusHub::setQueueLimit(std::size_t limit)
+{
+  prv->queueLimit = limit;
+}
+
+void BusHub::setBatchSize(std::size_t batchSize)
+{
+  if(batchSize == 0)
+  {
+    throw std::invalid_argument("BusHub: batch size must not be 0");
+  }
+  prv->batchSize = batchSize;
+}
+
+void BusHub::setPriorityMessageTypes(GstMessageType types)
+{
+  prv->priorityTypes = static_cast<guint>(types);
+}
+
+std::size_t BusHub::getPipelineCount() const
+{
+  std::lock_guard lock(prv->mutex);
+  return prv->entries.size();
+}
+
+std::size_t BusHub::getWorkerCount() const
+{
+  return prv->workers.size();
+}
+
+std::uint64_t BusHub::getDroppedCount() const
+{
+  return prv->droppedCount.load(std::memory_order_relaxed);
+}
+
+} // dh::gst
@@ -0,0 +1,121 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_BUSHUB_HPP
+#define DH_GST_BUSHUB_HPP
+
+// local includes
+#include "pipeline.hpp"
+#include "sharedptrs.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// C
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Services the buses of many pipelines with a small pool of worker threads.
+ * The hub installs a sync handler on each bus that moves the messages into a queue per pipeline
+ * (the messages are not queued on the bus anymore, so bus watches or pops see nothing).
+ * The workers handle the pipelines round robin, at most @ref setBatchSize messages at a time,
+ * so a pipeline flooding its bus can not starve the others.
+ * Messages of the priority types (default ERROR and EOS) are handled before the other queued messages of the pipeline,
+ * and a pipeline with a priority message is scheduled before all other pipelines.
+ * Informational messages are dropped if the queue of a pipeline is full, priority messages never.
+ * The messages of one pipeline are never handled by two workers at the same time.
+ */
+class BusHub
+{
+protected:
+  /**
+   * @brief Create a hub and start its workers.
+   * @param workerCount the number of worker threads
+   * @throws std::invalid_argument if workerCount is 0
+   */
+  explicit BusHub(std::size_t workerCount);
+
+public:
+  using Id = std::uint64_t;
+  using MessageSlot = std::function<void(GstMessageSPtr)>;
+
+  [[nodiscard]] static std::shared_ptr<BusHub> create(std::size_t workerCount = 2);
+
+  /**
+   * @brief Stops the workers and removes the sync handlers of all buses.
+   */
+  ~BusHub();
+
+  /**
+   * @brief Service the bus of the pipeline. The bus must not have a sync handler yet.
+   * @param pipeline the pipeline, it is not kept alive by the hub
+   * @param handler called from a worker thread for each message of the pipeline
+   * @return the id to remove the pipeline
+   * @throws std::invalid_argument if handler is empty
+   */
+  Id add(const Pipeline& pipeline, MessageSlot handler);
+
+  /**
+   * @brief Stop servicing the pipeline. Its queued messages are dropped.
+   * A handler call that is already running in a worker is not waited for, so it is safe to call from the handler.
+   * @param id the id returned by add
+   * @return false if the id is unknown
+   */
+  bool remove(Id id);
+
+  /**
+   * @brief Set the maximum number of queued informational messages per pipeline. Default: 1000
+   */
+  void setQueueLimit(std::size_t limit);
+
+  /**
+   * @brief Set the number of messages a worker handles of one pipeline before it moves on to the next. Default: 16
+   * @throws std::invalid_argument if batchSize is 0
+   */
+  void setBatchSize(std::size_t batchSize);
+
+  /**
+   * @brief Set the message types that are handled first and never dropped. Default: GST_MESSAGE_ERROR | GST_MESSAGE_EOS
+   * Extended types (e.g. GST_MESSAGE_STREAMS_SELECTED) only match if types contains GST_MESSAGE_EXTENDED.
+   */
+  void setPriorityMessageTypes(GstMessageType types);
+
+  [[nodiscard]] std::size_t getPipelineCount() const;
+  [[nodiscard]] std::size_t getWorkerCount() const;
+
+  /**
+   * @brief Get the number of informational messages dropped because of full queues.
+   */
+  [[nodiscard]] std::uint64_t getDroppedCount() const;
+
+private:
+  class Private;
+  std::shared_ptr<Private> prv; // shared with the bus sync handlers
+};
+
+} // dh::gst
+
+#endif //DH_GST_BUSHUB_HPP
@@ -0,0 +1,260 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "busmetrics.hpp"
+#include "helpers.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace dh::gst
+{
+
+namespace
+{
+constexpr std::size_t typeCounters = 32;
+
+/**
+ * @brief one counter per basic type (a single bit below GST_MESSAGE_EXTENDED), the last counter is shared
+ * by the extended types (GST_MESSAGE_EXTENDED | n reuses the low bits) and GST_MESSAGE_UNKNOWN
+ */
+std::size_t getTypeIndex(GstMessageType type)
+{
+  const auto bits = static_cast<guint>(type);
+  if((bits & GST_MESSAGE_EXTENDED) || bits == 0 || (bits & (bits - 1)) != 0)
+  {
+    return typeCounters - 1;
+  }
+  return static_cast<std::size_t>(g_bit_nth_lsf(bits, -1));
+}
+} // namespace
+
+class BusMetrics::Private
+{
+public:
+  struct SourceCounter
+  {
+    std::atomic<GQuark> source{0};
+    std::atomic<std::uint64_t> count{0};
+  };
+
+  std::array<std::atomic<std::uint64_t>, typeCounters> typeCounts{};
+  std::atomic<std::uint64_t> noSourceCount{0};
+  // open addressing with linear probing, entries are never removed
+  std::array<SourceCounter, maxSources> sourceCounts;
+  std::atomic<std::uint64_t> untrackedSourceCount{0};
+
+  std::array<std::atomic<std::uint64_t>, histogramBuckets> histogram{};
+  std::atomic<std::uint64_t> slowHandlerCount{0};
+  std::atomic<GstClockTime> latencyBudget{GST_MSECOND};
+
+  void countSource(GQuark source)
+  {
+    if(source == 0)
+    {
+      noSourceCount.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    const std::size_t hash = static_cast<std::size_t>(source) * 2654435761u;
+    for(std::size_t i = 0; i < maxSources; ++i)
+    {
+      SourceCounter& counter = sourceCounts[(hash + i) % maxSources];
+      GQuark current = counter.source.load(std::memory_order_acquire);
+      if(current == 0 && counter.source.compare_exchange_strong(current, source, std::memory_order_acq_rel))
+      {
+        current = source;
+      }
+      if(current == source)
+      {
+        counter.count.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+    untrackedSourceCount.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+BusMetrics::BusMetrics()
+: prv{std::make_unique<Private>()}
+{
+}
+
+BusMetrics::~BusMetrics() = default;
+
+std::shared_ptr<BusMetrics> BusMetrics::create()
+{
+  return std::shared_ptr<BusMetrics>(new BusMetrics());
+}
+
+bs2::connection BusMetrics::attach(const std::shared_ptr<Bus>& bus)
+{
+  if(! bus)
+  {
+    throw std::invalid_argument("BusMetrics: no bus given");
+  }
+  return bus->newSyncMessageSignal().connect(
+    [weakMetrics = weak_from_this()](GstMessageSPtr message)
+    {
+      if(const auto metrics = weakMetrics.lock())
+      {
+        metrics->countMessage(*message);
+      }
+    }
+  );
+}
+
+BusMetrics::MessageSlot BusMetrics::instrument(std::string handlerName, MessageSlot slot)
+{
+  return [weakMetrics = weak_from_this(), handlerName = std::move(handlerName), slot = std::move(slot)](GstMessageSPtr message)
+  {
+    const GstMessageType type = GST_MESSAGE_TYPE(message.get());
+    const GstClockTime start = gst_util_get_timestamp();
+    const auto record = [&]()
+    {
+      if(const auto metrics = weakMetrics.lock())
+      {
+        metrics->recordHandlerDuration(handlerName, type, gst_util_get_timestamp() - start);
+      }
+    };
+    try
+    {
+      slot(std::move(message));
+    }
+    catch(...)
+    {
+      record();
+      throw;
+    }
+    record();
+  };
+}
+
+void BusMetrics::countMessage(const GstMessage& message) noexcept
+{
+  prv->typeCounts[getTypeIndex(GST_MESSAGE_TYPE(&message))].fetch_add(1, std::memory_order_relaxed);
+  prv->countSource(helpers::getObjectNameQuark(GST_MESSAGE_SRC(&message)));
+}
+
+void BusMetrics::recordHandlerDuration(std::string_view handlerName, GstMessageType type, GstClockTime duration)
+{
+  const auto bucket = static_cast<std::size_t>(duration == 0 ? 0 : g_bit_storage(duration));
+  prv->histogram[std::min(bucket, histogramBuckets - 1)].fetch_add(1, std::memory_order_relaxed);
+
+  if(duration <= prv->latencyBudget.load(std::memory_order_relaxed))
+  {
+    return;
+  }
+  prv->slowHandlerCount.fetch_add(1, std::memory_order_relaxed);
+  GST_WARNING(
+    "BusMetrics: handler '%.*s' took %" GST_TIME_FORMAT " for a %s message",
+    static_cast<int>(handlerName.size()),
+    handlerName.data(),
+    GST_TIME_ARGS(duration),
+    gst_message_type_get_name(type)
+  );
+  slowHandlerSignal(handlerName, type, duration);
+}
+
+void BusMetrics::setLatencyBudget(GstClockTime budget)
+{
+  prv->latencyBudget = budget;
+}
+
+GstClockTime BusMetrics::getLatencyBudget() const
+{
+  return prv->latencyBudget;
+}
+
+std::uint64_t BusMetrics::getMessageCount(GstMessageType type) const
+{
+  return prv->typeCounts[getTypeIndex(type)].load(std::memory_order_relaxed);
+}
+
+std::uint64_t BusMetrics::getTotalMessageCount() const
+{
+  std::uint64_t total = 0;
+  for(const auto& count : prv->typeCounts)
+  {
+    total += count.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+std::vector<std::pair<GQuark, std::uint64_t>> BusMetrics::getSourceCounts() const
+{
+  std::vector<std::pair<GQuark, std::uint64_t>> counts;
+  if(const auto noSourceCount = prv->noSourceCount.load(std::memory_order_relaxed))
+  {
+    counts.emplace_back(0, noSourceCount);
+  }
+  for(const auto& counter : prv->sourceCounts)
+  {
+    const GQuark source = counter.source.load(std::memory_order_acquire);
+    if(source != 0)
+    {
+      counts.emplace_back(source, counter.count.load(std::memory_order_relaxed));
+    }
+  }
+  return counts;
+}
+
+std::uint64_t BusMetrics::getUntrackedSourceCount() const
+{
+  return prv->untrackedSourceCount.load(std::memory_order_relaxed);
+}
+
+BusMetrics::Histogram BusMetrics::getHandlerHistogram() const
+{
+  Histogram histogram{};
+  for(std::size_t i = 0; i < histogramBuckets; ++i)
+  {
+    histogram[i] = prv->histogram[i].load(std::memory_order_relaxed);
+  }
+  return histogram;
+}
+
+std::uint64_t BusMetrics::getSlowHandlerCount() const
+{
+  return prv->slowHandlerCount.load(std::memory_order_relaxed);
+}
+
+void BusMetrics::reset()
+{
+  for(auto& count : prv->typeCounts)
+  {
+    count = 0;
+  }
+  prv->noSourceCount = 0;
+  for(auto& counter : prv->sourceCounts)
+  {
+    counter.count = 0;
+  }
+  prv->untrackedSourceCount = 0;
+  for(auto& count : prv->histogram)
+  {
+    count = 0;
+  }
+  prv->slowHandlerCount = 0;
+}
+
+} // dh::gst
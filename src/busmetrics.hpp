@@ -0,0 +1,156 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_BUSMETRICS_HPP
+#define DH_GST_BUSMETRICS_HPP
+
+// local includes
+#include "bus.hpp"
+#include "sharedptrs.hpp"
+
+// boost
+#include <boost/signals2.hpp>
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// C
+#include <gst/gst.h>
+
+namespace bs2 = boost::signals2;
+
+namespace dh::gst
+{
+
+/**
+ * @brief Counts bus messages per type and per source and measures the duration of message handlers.
+ * Handlers of sync messages run in the streaming threads, a slow one throttles the pipeline.
+ * Handlers that exceed the latency budget are reported with @ref slowHandlerSignal.
+ * Counting and measuring uses atomic counters only, no locks and no allocations.
+ *
+ * Usage:
+ * @code
+ * auto metrics = BusMetrics::create();
+ * metrics->attach(bus); // count all messages of the bus
+ * bus->newSyncMessageSignal().connect(metrics->instrument("overlay", overlaySlot)); // measure a sync slot
+ * parser->setMetrics(metrics); // measure each slot of the MessageParser signals
+ * @endcode
+ */
+class BusMetrics : public std::enable_shared_from_this<BusMetrics>
+{
+protected:
+  BusMetrics();
+
+public:
+  using MessageSlot = std::function<void(GstMessageSPtr)>;
+
+  /// bucket i counts durations in [2^(i-1), 2^i) nanoseconds, bucket 0 counts 0ns
+  static constexpr std::size_t histogramBuckets = 65;
+  using Histogram = std::array<std::uint64_t, histogramBuckets>;
+
+  /// per source counters, further sources are counted in @ref getUntrackedSourceCount
+  static constexpr std::size_t maxSources = 1024;
+
+  [[nodiscard]] static std::shared_ptr<BusMetrics> create();
+
+  ~BusMetrics();
+
+  /**
+   * @brief Count all messages of the bus, from the posting threads.
+   * @param bus the bus
+   * @return the connection to @ref Bus::newSyncMessageSignal
+   * @throws std::invalid_argument if bus is empty
+   */
+  bs2::connection attach(const std::shared_ptr<Bus>& bus);
+
+  /**
+   * @brief Wrap a slot, so its duration is measured.
+   * @param handlerName name used for reports of slow handlers
+   * @param slot the slot to measure
+   * @return the wrapping slot to connect instead of slot. It only keeps a weak reference to the metrics.
+   */
+  [[nodiscard]] MessageSlot instrument(std::string handlerName, MessageSlot slot);
+
+  /**
+   * @brief Count one message.
+   */
+  void countMessage(const GstMessage& message) noexcept;
+
+  /**
+   * @brief Add a handler duration to the histogram and report it if it exceeds the latency budget.
+   * @param handlerName name of the handler
+   * @param type type of the handled message
+   * @param duration the duration in nanoseconds
+   */
+  void recordHandlerDuration(std::string_view handlerName, GstMessageType type, GstClockTime duration);
+
+  /**
+   * @brief Set the maximum duration of a handler before it is reported as slow. Default: 1ms
+   */
+  void setLatencyBudget(GstClockTime budget);
+  [[nodiscard]] GstClockTime getLatencyBudget() const;
+
+  /**
+   * @brief Get the number of counted messages of one type.
+   * @param type a single message type. All extended types (e.g. GST_MESSAGE_STREAMS_SELECTED) and
+   * GST_MESSAGE_UNKNOWN share one counter, which is returned for any of them.
+   */
+  [[nodiscard]] std::uint64_t getMessageCount(GstMessageType type) const;
+  [[nodiscard]] std::uint64_t getTotalMessageCount() const;
+
+  /**
+   * @brief Get the message counts per source.
+   * @return pairs of the source name quark (0 for messages without source) and the count
+   */
+  [[nodiscard]] std::vector<std::pair<GQuark, std::uint64_t>> getSourceCounts() const;
+  [[nodiscard]] std::uint64_t getUntrackedSourceCount() const;
+
+  [[nodiscard]] Histogram getHandlerHistogram() const;
+  [[nodiscard]] std::uint64_t getSlowHandlerCount() const;
+
+  /**
+   * @brief Set all counters to 0. Not atomic with respect to concurrent counting.
+   */
+  void reset();
+
+  /**
+   * @brief Emitted when a handler exceeded the latency budget, from the thread that ran the handler.
+   * @param handlerName the name of the handler
+   * @param type the type of the handled message
+   * @param duration the duration of the handler
+   */
+  bs2::signal<void(std::string_view handlerName, GstMessageType type, GstClockTime duration)> slowHandlerSignal;
+
+private:
+  class Private;
+  std::unique_ptr<Private> prv;
+};
+
+} // dh::gst
+
+#endif //DH_GST_BUSMETRICS_HPP
@@ -0,0 +1,279 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "clockgroup.hpp"
+
+// std
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+// C
+#include <gst/net/net.h>
+
+namespace dh::gst
+{
+
+namespace
+{
+GstClockTime getSystemTime()
+{
+  // gst_system_clock_obtain: transfer full
+  const auto systemClock = makeGstSharedPtr(gst_system_clock_obtain(), TransferType::Full);
+  return gst_clock_get_time(systemClock.get());
+}
+} // namespace
+
+class ClockGroup::Private
+{
+public:
+  GstClockSPtr clock;
+  mutable std::mutex mutex;
+  std::vector<std::weak_ptr<Pipeline>> pipelines;
+  GstClockTime baseTime{GST_CLOCK_TIME_NONE};
+  GstObjectSPtr timeProvider;
+
+  // reference points for the drift, taken when the clock is seen synced the first time
+  // (a net client clock jumps and adjusts its rate until then), guarded by the mutex
+  GstClockTime referenceClockTime{GST_CLOCK_TIME_NONE};
+  GstClockTime referenceSystemTime{GST_CLOCK_TIME_NONE};
+
+  /**
+   * @brief take the reference points for the drift if not done yet and the clock is synced, called with lock
+   * @return true if the reference points are valid
+   */
+  bool takeDriftReference()
+  {
+    if(GST_CLOCK_TIME_IS_VALID(referenceClockTime))
+    {
+      return true;
+    }
+    if(! gst_clock_is_synced(clock.get()))
+    {
+      return false;
+    }
+    referenceClockTime = gst_clock_get_time(clock.get());
+    referenceSystemTime = getSystemTime();
+    return true;
+  }
+
+  void applyBaseTime(GstElement* element) const
+  {
+    gst_element_set_start_time(element, GST_CLOCK_TIME_NONE);
+    gst_element_set_base_time(element, baseTime);
+  }
+
+  std::vector<std::shared_ptr<Pipeline>> lockPipelines()
+  {
+    std::vector<std::shared_ptr<Pipeline>> result;
+    pipelines.erase(
+      std::remove_if(pipelines.begin(), pipelines.end(), [](const auto& pipeline){ return pipeline.expired(); }),
+      pipelines.end()
+    );
+    for(const auto& weakPipeline : pipelines)
+    {
+      if(auto pipeline = weakPipeline.lock())
+      {
+        result.push_back(std::move(pipeline));
+      }
+    }
+    return result;
+  }
+};
+
+ClockGroup::ClockGroup(GstClockSPtr clock)
+: prv{std::make_unique<Private>()}
+{
+  prv->clock = clock ? std::move(clock) : makeGstSharedPtr(gst_system_clock_obtain(), TransferType::Full);
+  std::lock_guard lock(prv->mutex);
+  prv->takeDriftReference();
+}
+
+ClockGroup::~ClockGroup() = default;
+
+std::shared_ptr<ClockGroup> ClockGroup::create(GstClockSPtr clock)
+{
+  return std::shared_ptr<ClockGroup>(new ClockGroup(std::move(clock)));
+}
+
+std::shared_ptr<ClockGroup> ClockGroup::createNetClient(const std::string& address, int port)
+{
+  // gst_net_client_clock_new: transfer full
+  GstClock* clock = gst_net_client_clock_new(nullptr, address.c_str(), port, 0);
+  if(! clock)
+  {
+    throw std::runtime_error("ClockGroup: failed to create net client clock for " + address + ":" + std::to_string(port));
+  }
+  return create(makeGstSharedPtr(clock, TransferType::Full));
+}
+
+void ClockGroup::add(const std::shared_ptr<Pipeline>& pipeline)
+{
+  if(! pipeline)
+  {
+    throw std::invalid_argument("ClockGroup: no pipeline given");
+  }
+  GstPipeline* gstPipeline = pipeline->getGstPipeline().get();
+  gst_pipeline_use_clock(gstPipeline, prv->clock.get());
+
+  std::lock_guard lock(prv->mutex);
+  if(GST_CLOCK_TIME_IS_VALID(prv->baseTime))
+  {
+    prv->applyBaseTime(GST_ELEMENT_CAST(gstPipeline));
+  }
+  prv->pipelines.push_back(pipeline);
+}
+
+void ClockGroup::remove(const std::shared_ptr<Pipeline>& pipeline)
+{
+  if(! pipeline)
+  {
+    return;
+  }
+  {
+    std::lock_guard lock(prv->mutex);
+    prv->pipelines.erase(
+      std::remove_if(
+        prv->pipelines.begin(),
+        prv->pipelines.end(),
+        [&pipeline](const auto& weakPipeline){ return weakPipeline.expired() || weakPipeline.lock() == pipeline; }
+      ),
+      prv->pipelines.end()
+    );
+  }
+  GstPipeline* gstPipeline = pipeline->getGstPipeline().get();
+  gst_pipeline_auto_clock(gstPipeline);
+  gst_element_set_start_time(GST_ELEMENT_CAST(gstPipeline), 0);
+}
+
+void ClockGroup::setBaseTime(GstClockTime baseTime)
+{
+  std::lock_guard lock(prv->mutex);
+  prv->baseTime = baseTime;
+  for(const auto& pipeline : prv->lockPipelines())
+  {
+    prv->applyBaseTime(GST_ELEMENT_CAST(pipeline->getGstPipeline().get()));
+  }
+}
+
+GstClockTime ClockGroup::startTogether(GstClockTime delay)
+{
+  const GstClockTime baseTime = gst_clock_get_time(prv->clock.get()) + delay;
+  setBaseTime(baseTime);
+
+  std::vector<std::shared_ptr<Pipeline>> pipelines;
+  {
+    std::lock_guard lock(prv->mutex);
+    pipelines = prv->lockPipelines();
+  }
+  for(const auto& pipeline : pipelines)
+  {
+    if(pipeline->setState(GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    {
+      GST_WARNING("ClockGroup: failed to start pipeline '%s'", pipeline->getName().c_str());
+    }
+  }
+  return baseTime;
+}
+
+GstClockTime ClockGroup::getBaseTime() const
+{
+  std::lock_guard lock(prv->mutex);
+  return prv->baseTime;
+}
+
+GstClockSPtr ClockGroup::getClock() const
+{
+  return prv->clock;
+}
+
+std::size_t ClockGroup::getPipelineCount() const
+{
+  std::lock_guard lock(prv->mutex);
+  return prv->lockPipelines().size();
+}
+
+int ClockGroup::startTimeProvider(const std::string& address, int port)
+{
+  // gst_net_time_provider_new: transfer full
+  GstNetTimeProvider* provider = gst_net_time_provider_new(prv->clock.get(), address.c_str(), port);
+  if(! provider)
+  {
+    throw std::runtime_error("ClockGroup: failed to create time provider on " + address + ":" + std::to_string(port));
+  }
+  gint boundPort = 0;
+  g_object_get(G_OBJECT(provider), "port", &boundPort, nullptr);
+
+  std::lock_guard lock(prv->mutex);
+  prv->timeProvider = makeGstSharedPtr(GST_OBJECT_CAST(provider), TransferType::Full);
+  return boundPort;
+}
+
+void ClockGroup::stopTimeProvider()
+{
+  std::lock_guard lock(prv->mutex);
+  prv->timeProvider.reset();
+}
+
+bool ClockGroup::waitForSync(GstClockTime timeout)
+{
+  if(! gst_clock_wait_for_sync(prv->clock.get(), timeout))
+  {
+    return false;
+  }
+  std::lock_guard lock(prv->mutex);
+  prv->takeDriftReference();
+  return true;
+}
+
+ClockGroup::ClockStats ClockGroup::getClockStats() const
+{
+  GstClock* clock = prv->clock.get();
+  ClockStats stats{};
+  stats.synced = gst_clock_is_synced(clock);
+
+  GstClockTime internal = 0;
+  GstClockTime external = 0;
+  GstClockTime rateNum = 1;
+  GstClockTime rateDenom = 1;
+  gst_clock_get_calibration(clock, &internal, &external, &rateNum, &rateDenom);
+  stats.rate = rateDenom ? static_cast<double>(rateNum) / static_cast<double>(rateDenom) : 1.0;
+
+  const GstClockTime systemTime = getSystemTime();
+  const GstClockTime clockTime = gst_clock_get_time(clock);
+  stats.offset = GST_CLOCK_DIFF(systemTime, clockTime);
+
+  std::lock_guard lock(prv->mutex);
+  if(! prv->takeDriftReference())
+  {
+    stats.driftPpm = 0.0;
+    return stats;
+  }
+  const GstClockTimeDiff systemElapsed = GST_CLOCK_DIFF(prv->referenceSystemTime, systemTime);
+  const GstClockTimeDiff clockElapsed = GST_CLOCK_DIFF(prv->referenceClockTime, clockTime);
+  stats.driftPpm = systemElapsed > 0
+    ? static_cast<double>(clockElapsed - systemElapsed) * 1e6 / static_cast<double>(systemElapsed)
+    : 0.0;
+  return stats;
+}
+
+} // dh::gst
@@ -0,0 +1,156 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_CLOCKGROUP_HPP
+#define DH_GST_CLOCKGROUP_HPP
+
+// local includes
+#include "pipeline.hpp"
+#include "sharedptrs.hpp"
+
+// std
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// C
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Synchronizes a group of pipelines: all use the same clock and the same base time,
+ * so their running times are equal and their sinks render the same timestamps at the same moment.
+ * The clock can be published with a GstNetTimeProvider, pipelines in other processes (or on other hosts)
+ * use a group created with @ref createNetClient on the same base time.
+ * @code
+ * auto group = ClockGroup::create();
+ * group->add(leftPipeline);
+ * group->add(rightPipeline);
+ * group->startTogether();
+ * @endcode
+ */
+class ClockGroup
+{
+protected:
+  /**
+   * @brief Create a group for the clock.
+   * @param clock the clock, the system clock if empty
+   */
+  explicit ClockGroup(GstClockSPtr clock);
+
+public:
+  struct ClockStats
+  {
+    bool synced;               ///< gst_clock_is_synced, always true for local clocks
+    double rate;               ///< calibrated rate of the clock against its internal clock, 1.0 if not slaved
+    double driftPpm;           ///< drift against the local system clock since the clock was first seen synced, in parts per million, 0 before
+    GstClockTimeDiff offset;   ///< time of the clock minus time of the local system clock
+  };
+
+  [[nodiscard]] static std::shared_ptr<ClockGroup> create(GstClockSPtr clock = {});
+
+  /**
+   * @brief Create a group with a GstNetClientClock that follows the GstNetTimeProvider at address and port.
+   * The clock needs some time to synchronize, see @ref waitForSync.
+   * @param address the address of the time provider, e.g. "127.0.0.1"
+   * @param port the port of the time provider
+   * @throws std::runtime_error if the clock can not be created
+   */
+  [[nodiscard]] static std::shared_ptr<ClockGroup> createNetClient(const std::string& address, int port);
+
+  /**
+   * @brief stops the time provider. The pipelines keep the clock.
+   */
+  ~ClockGroup();
+
+  /**
+   * @brief Let the pipeline use the clock of the group.
+   * If the group has a base time, the pipeline uses it too (also after pausing).
+   * The group only keeps a weak reference.
+   * @param pipeline the pipeline
+   * @throws std::invalid_argument if pipeline is empty
+   */
+  void add(const std::shared_ptr<Pipeline>& pipeline);
+
+  /**
+   * @brief Let the pipeline select its clock and base time again.
+   * @param pipeline the pipeline
+   */
+  void remove(const std::shared_ptr<Pipeline>& pipeline);
+
+  /**
+   * @brief Set the base time of all pipelines of the group.
+   * The pipelines don't change the base time on their own anymore (start time GST_CLOCK_TIME_NONE).
+   * @param baseTime a time of the group clock, e.g. received from the process that called @ref startTogether
+   */
+  void setBaseTime(GstClockTime baseTime);
+
+  /**
+   * @brief Set the base time to now + delay and set all pipelines to PLAYING.
+   * The delay gives the pipelines time to preroll, so the first frames are rendered at the same time.
+   * @param delay time between now and running time 0
+   * @return the base time, to distribute to groups in other processes
+   */
+  GstClockTime startTogether(GstClockTime delay = 100 * GST_MSECOND);
+
+  /**
+   * @brief Get the base time of the group.
+   * @return the base time or GST_CLOCK_TIME_NONE if not set
+   */
+  [[nodiscard]] GstClockTime getBaseTime() const;
+
+  [[nodiscard]] GstClockSPtr getClock() const;
+
+  /**
+   * @brief Get the number of pipelines in the group that still exist.
+   */
+  [[nodiscard]] std::size_t getPipelineCount() const;
+
+  /**
+   * @brief Publish the clock of the group on the network with a GstNetTimeProvider.
+   * @param address the address to listen on, e.g. "127.0.0.1" for pipelines in other processes on this host
+   * @param port the port, 0 to select a free one
+   * @return the port
+   * @throws std::runtime_error if the provider can not be created
+   */
+  int startTimeProvider(const std::string& address = "127.0.0.1", int port = 0);
+
+  void stopTimeProvider();
+
+  /**
+   * @brief Wait until the clock is synchronized, e.g. a GstNetClientClock got enough samples.
+   * The drift of @ref getClockStats is measured from the first time the clock is seen synced.
+   * @param timeout maximum time to wait
+   * @return true if synced
+   */
+  bool waitForSync(GstClockTime timeout);
+
+  [[nodiscard]] ClockStats getClockStats() const;
+
+private:
+  class Private;
+  std::unique_ptr<Private> prv;
+};
+
+} // dh::gst
+
+#endif //DH_GST_CLOCKGROUP_HPP
@@ -23,6 +23,9 @@
 #include "elementfactory.hpp"
 
 // std
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 
 // C
@@ -32,6 +35,213 @@
 namespace dh::gst
 {
 
+namespace
+{
+/**
+ * @brief One running setStateAsync. Kept alive by the bus handler, the timeout and the thread pool task
+ * until it has completed.
+ */
+class AsyncStateChange : public std::enable_shared_from_this<AsyncStateChange>
+{
+public:
+  AsyncStateChange(GstElementSPtr element, GstState target, Element::StateChangeCallback callback)
+  : element{std::move(element)}
+  , target{target}
+  , callback{std::move(callback)}
+  {
+  }
+
+  void start(GstClockTime timeout)
+  {
+    {
+      std::lock_guard lock(mutex);
+      // gst_element_get_bus: transfer full, nullable
+      bus = makeGstSharedPtr(gst_element_get_bus(element.get()), TransferType::Full);
+      if(bus)
+      {
+        // connect before changing the state, so no message is missed
+        gst_bus_enable_sync_message_emission(bus.get());
+        handlerId = g_signal_connect_data(
+          bus.get(),
+          "sync-message",
+          G_CALLBACK(&AsyncStateChange::onSyncMessage),
+          new std::shared_ptr<AsyncStateChange>(shared_from_this()),
+          [](gpointer data, GClosure*){ delete static_cast<std::shared_ptr<AsyncStateChange>*>(data); },
+          static_cast<GConnectFlags>(0)
+        );
+      }
+    }
+
+    const GstStateChangeReturn result = gst_element_set_state(element.get(), target);
+    if(result != GST_STATE_CHANGE_ASYNC)
+    {
+      complete(result);
+      return;
+    }
+
+    if(! bus)
+    {
+      waitInThreadPool(timeout);
+      return;
+    }
+
+    {
+      std::lock_guard lock(mutex);
+      if(done)
+      {
+        return;
+      }
+      if(GST_CLOCK_TIME_IS_VALID(timeout))
+      {
+        startTimeout(timeout);
+      }
+    }
+
+    // the state could have been reached before the handler was connected to the bus
+    checkState();
+  }
+
+private:
+  void startTimeout(GstClockTime timeout)
+  {
+    // gst_system_clock_obtain: transfer full
+    clock = makeGstSharedPtr(gst_system_clock_obtain(), TransferType::Full);
+    clockId = gst_clock_new_single_shot_id(clock.get(), gst_clock_get_time(clock.get()) + timeout);
+    gst_clock_id_wait_async(
+      clockId,
+      [](GstClock*, GstClockTime, GstClockID, gpointer data) -> gboolean
+      {
+        GST_DEBUG("setStateAsync: timeout");
+        (*static_cast<std::shared_ptr<AsyncStateChange>*>(data))->complete(GST_STATE_CHANGE_ASYNC);
+        return TRUE;
+      },
+      new std::shared_ptr<AsyncStateChange>(shared_from_this()),
+      [](gpointer data){ delete static_cast<std::shared_ptr<AsyncStateChange>*>(data); }
+    );
+  }
+
+  void waitInThreadPool(GstClockTime timeout)
+  {
+    this->timeout = timeout;
+    gst_element_call_async(
+      element.get(),
+      [](GstElement* gstElement, gpointer data)
+      {
+        auto& self = *static_cast<std::shared_ptr<AsyncStateChange>*>(data);
+        self->complete(gst_element_get_state(gstElement, nullptr, nullptr, self->timeout));
+      },
+      new std::shared_ptr<AsyncStateChange>(shared_from_this()),
+      [](gpointer data){ delete static_cast<std::shared_ptr<AsyncStateChange>*>(data); }
+    );
+  }
+
+  void checkState()
+  {
+    GstState current;
+    GstState pending;
+    const GstStateChangeReturn result = gst_element_get_state(element.get(), &current, &pending, 0);
+    if(result == GST_STATE_CHANGE_FAILURE)
+    {
+      complete(result);
+    }
+    else if(result != GST_STATE_CHANGE_ASYNC && current == target && pending == GST_STATE_VOID_PENDING)
+    {
+      complete(result);
+    }
+  }
+
+  static void onSyncMessage(GstBus* /*bus*/, GstMessage* message, gpointer data)
+  {
+    auto& self = *static_cast<std::shared_ptr<AsyncStateChange>*>(data);
+    GstObject* source = GST_MESSAGE_SRC(message);
+    auto* elementObject = GST_OBJECT_CAST(self->element.get());
+
+    switch(GST_MESSAGE_TYPE(message))
+    {
+      case GST_MESSAGE_STATE_CHANGED:
+      {
+        if(source != elementObject)
+        {
+          return;
+        }
+        GstState oldState, newState, pendingState;
+        gst_message_parse_state_changed(message, &oldState, &newState, &pendingState);
+        if(newState == self->target && pendingState == GST_STATE_VOID_PENDING)
+        {
+          self->checkState();
+        }
+        break;
+      }
+      case GST_MESSAGE_ASYNC_DONE:
+      {
+        if(source == elementObject)
+        {
+          self->checkState();
+        }
+        break;
+      }
+      case GST_MESSAGE_ERROR:
+      {
+        if(source && (source == elementObject || gst_object_has_as_ancestor(source, elementObject)))
+        {
+          GST_DEBUG_OBJECT(self->element.get(), "setStateAsync: error from '%s'", GST_OBJECT_NAME(source));
+          self->complete(GST_STATE_CHANGE_FAILURE);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  void complete(GstStateChangeReturn result)
+  {
+    if(done.exchange(true))
+    {
+      return;
+    }
+    // disconnecting can release the last reference
+    const auto self = shared_from_this();
+    {
+      std::lock_guard lock(mutex);
+      if(bus && handlerId != 0)
+      {
+        g_signal_handler_disconnect(bus.get(), handlerId);
+        gst_bus_disable_sync_message_emission(bus.get());
+        handlerId = 0;
+      }
+      if(clockId)
+      {
+        gst_clock_id_unschedule(clockId);
+        gst_clock_id_unref(clockId);
+        clockId = nullptr;
+      }
+    }
+
+    try
+    {
+      callback(result);
+    }
+    catch(const std::exception& e)
+    {
+      GST_ERROR_OBJECT(element.get(), "setStateAsync: callback threw: %s", e.what());
+    }
+  }
+
+  GstElementSPtr element;
+  const GstState target;
+  Element::StateChangeCallback callback;
+  GstClockTime timeout{GST_CLOCK_TIME_NONE};
+
+  std::atomic<bool> done{false};
+  std::mutex mutex;
+  GstBusSPtr bus;
+  gulong handlerId{0};
+  GstClockSPtr clock;
+  GstClockID clockId{nullptr};
+};
+} // namespace
+
 Element::Element(GstElement* gstElement, TransferType transferType)
 : Object(GST_OBJECT_CAST(gstElement), transferType)
 {
@@ -71,6 +281,30 @@ GstStateChangeReturn Element::setState(GstState newState)
   return gst_element_set_state(getRawGstElement(), newState);
 }
 
+void Element::setStateAsync(GstState newState, StateChangeCallback callback, GstClockTime timeout)
+{
+  if(! callback)
+  {
+    throw std::invalid_argument("setStateAsync: no callback given");
+  }
+  std::make_shared<AsyncStateChange>(getGstElement(), newState, std::move(callback))->start(timeout);
+}
+
+std::future<GstStateChangeReturn> Element::setStateAsync(GstState newState, GstClockTime timeout)
+{
+  auto promise = std::make_shared<std::promise<GstStateChangeReturn>>();
+  auto future = promise->get_future();
+  setStateAsync(
+    newState,
+    [promise](GstStateChangeReturn result)
+    {
+      promise->set_value(result);
+    },
+    timeout
+  );
+  return future;
+}
+
 std::vector<GstPad*> Element::getPads()
 {
   std::vector<GstPad*> pads;
@@ -118,6 +352,21 @@ std::vector<GstPad*> Element::getSrcPads()
   return srcPads;
 }
 
+PadRange Element::iteratePads()
+{
+  return PadRange(gst_element_iterate_pads(getRawGstElement()));
+}
+
+PadRange Element::iterateSinkPads()
+{
+  return PadRange(gst_element_iterate_sink_pads(getRawGstElement()));
+}
+
+PadRange Element::iterateSrcPads()
+{
+  return PadRange(gst_element_iterate_src_pads(getRawGstElement()));
+}
+
 GstPad* Element::getCompatiblePad(GstPad* pad, GstCaps* caps)
 {
   return gst_element_get_compatible_pad(getRawGstElement(), pad, caps);
@@ -175,6 +424,13 @@ GstState Element::getState() const
   return state;
 }
 
+Element::StateInfo Element::getState(GstClockTime timeout) const
+{
+  StateInfo info{};
+  info.result = gst_element_get_state(const_cast<GstElement*>(getRawGstElement()), &info.current, &info.pending, timeout);
+  return info;
+}
+
 void Element::unlink(std::shared_ptr<Element>& other)
 {
   gst_element_unlink(getRawGstElement(), other->getRawGstElement());
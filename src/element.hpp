@@ -22,6 +22,7 @@
 #define DH_GST_ELEMENT_H
 
 // local includes
+#include "iteratorrange.hpp"
 #include "object.hpp"
 #include "sharedptrs.hpp"
 #include "transfertype.hpp"
@@ -30,6 +31,8 @@
 #include <boost/signals2.hpp>
 
 // std
+#include <functional>
+#include <future>
 #include <string>
 #include <vector>
 
@@ -78,6 +81,32 @@ protected:
 
   GstStateChangeReturn setState(GstState newState);
 
+  /**
+   * @brief called when an asynchronous state change has finished, see @ref setStateAsync
+   */
+  using StateChangeCallback = std::function<void(GstStateChangeReturn result)>;
+
+  /**
+   * @brief Change the state without waiting for ASYNC transitions.
+   * Completion is detected from the STATE_CHANGED messages of the element on its bus, no thread waits for it.
+   * Elements without bus are waited for in the GStreamer thread pool (gst_element_call_async).
+   * The callback is called exactly once, from the calling thread if the state change did not return ASYNC,
+   * otherwise from a streaming thread (bus sync message) or the clock thread (timeout).
+   * @param newState the target state
+   * @param callback called with SUCCESS or NO_PREROLL if the state was reached,
+   * FAILURE if the state change or an element in it failed (ERROR message) and ASYNC on timeout
+   * @param timeout maximum time to wait for ASYNC transitions, GST_CLOCK_TIME_NONE to wait forever
+   */
+  void setStateAsync(GstState newState, StateChangeCallback callback, GstClockTime timeout = GST_CLOCK_TIME_NONE);
+
+  /**
+   * @brief Like @ref setStateAsync with callback, but the result is delivered with a future.
+   * @param newState the target state
+   * @param timeout maximum time to wait for ASYNC transitions, GST_CLOCK_TIME_NONE to wait forever
+   * @return the future result, see the callback of @ref setStateAsync
+   */
+  [[nodiscard]] std::future<GstStateChangeReturn> setStateAsync(GstState newState, GstClockTime timeout = GST_CLOCK_TIME_NONE);
+
  /**
   * @brief Gets all pads of the GStreamer element.
   * @return (transfer none): A vector containing pointers to all GstPad objects.
@@ -99,6 +128,22 @@ protected:
   */
   [[nodiscard]] std::vector<GstPad*> getSrcPads();
 
+ /**
+  * @brief Lazily iterates all pads of the GStreamer element without building a vector.
+  * @return single pass range of referenced pads
+  */
+  [[nodiscard]] PadRange iteratePads();
+
+ /**
+  * @brief Lazily iterates the sink pads of the GStreamer element, see @ref iteratePads
+  */
+  [[nodiscard]] PadRange iterateSinkPads();
+
+ /**
+  * @brief Lazily iterates the source pads of the GStreamer element, see @ref iteratePads
+  */
+  [[nodiscard]] PadRange iterateSrcPads();
+
  /**
   * @brief Finds a compatible pad for a given pad and caps.
   * @param pad (transfer none): The GstPad to find a compatible pad for.
@@ -148,10 +193,26 @@ protected:
 
   /**
    * @brief Gets the current state of the element.
+   * Waits until an ASYNC state change has finished, which can be forever (e.g. a sink that never prerolls).
+   * Use @ref getState(GstClockTime) const with a timeout in monitoring code.
    * @return The current GstState of the element.
    */
   [[nodiscard]] GstState getState() const;
 
+  struct StateInfo
+  {
+    GstStateChangeReturn result; ///< ASYNC if the state change is still running after the timeout
+    GstState current;
+    GstState pending;            ///< GST_STATE_VOID_PENDING if no state change is running
+  };
+
+  /**
+   * @brief Gets the state of the element, waiting at most timeout for a running ASYNC state change.
+   * @param timeout the maximum time to wait, 0 to not wait at all
+   * @return the result of the last state change, the current and the pending state
+   */
+  [[nodiscard]] StateInfo getState(GstClockTime timeout) const;
+
   /**
    * @brief Unlinks the element from another element.
    * @param other The Element to unlink from.
@@ -73,5 +73,30 @@ GstVideoInfo createVideoInfo(const GstBuffer& buffer)
   return vinfo;
 }
 
+GQuark getObjectNameQuark(GstObject* object)
+{
+  static const GQuark cacheQuark = g_quark_from_static_string("dh-gst-name-quark");
+  if(! object)
+  {
+    return 0;
+  }
+  if(const gpointer cached = g_object_get_qdata(G_OBJECT(object), cacheQuark))
+  {
+    return GPOINTER_TO_UINT(cached);
+  }
+  const gchar* name = GST_OBJECT_NAME(object);
+  const GQuark quark = g_quark_from_string(name ? name : "unknown");
+  g_object_set_qdata(G_OBJECT(object), cacheQuark, GUINT_TO_POINTER(quark));
+  return quark;
+}
+
+bool isMessageTypeInMask(GstMessageType type, GstMessageType mask)
+{
+  if((type & mask) == 0)
+  {
+    return false;
+  }
+  return (type & GST_MESSAGE_EXTENDED) == 0 || (mask & GST_MESSAGE_EXTENDED) != 0;
+}
 
 } // dh::gst::helpers
@@ -54,6 +54,25 @@ GstVideoInfo createVideoInfo(const GstCaps& caps);
  */
 GstVideoInfo createVideoInfo(const GstBuffer& buffer);
 
+/**
+ * @brief Get the name of the object as quark, for code paths that must not copy strings.
+ * The quark is looked up once and cached on the object, later calls only take the per object data lock
+ * instead of the global quark lock. A later rename of the object is not noticed.
+ * @param object the object, can be nullptr
+ * @return the quark of the name, 0 for nullptr
+ */
+GQuark getObjectNameQuark(GstObject* object);
+
+/**
+ * @brief Check if a message type is in a mask of message types, like gst_bus_timed_pop_filtered does.
+ * Extended types (GST_MESSAGE_EXTENDED | n) reuse the low bits, e.g. GST_MESSAGE_STREAMS_SELECTED contains
+ * the bit of GST_MESSAGE_EOS. So they only match a mask that contains GST_MESSAGE_EXTENDED.
+ * @param type the type of a message
+ * @param mask the mask, e.g. GST_MESSAGE_ERROR | GST_MESSAGE_EOS
+ * @return true if the type matches the mask
+ */
+bool isMessageTypeInMask(GstMessageType type, GstMessageType mask);
+
 
 } // dh::gst::helpers
 
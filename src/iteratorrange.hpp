@@ -0,0 +1,308 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_ITERATORRANGE_HPP
+#define DH_GST_ITERATORRANGE_HPP
+
+// local includes
+#include "sharedptrs.hpp"
+#include "transfertype.hpp"
+#include "typetraits.hpp"
+
+// std
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// gst
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Holds a reference to a GstObject like GstObjectSPtr, but without a heap allocated control block.
+ * Copying increases the reference count of the GstObject.
+ */
+template<typename T>
+class ObjectRef
+{
+  static_assert(IsGstObject<T>::value, "ObjectRef needs a GstObject type");
+
+public:
+  ObjectRef() = default;
+
+  /**
+   * @param object the object, may be nullptr
+   * @param transferType see @ref makeGstSharedPtr
+   */
+  ObjectRef(T* object, TransferType transferType)
+  : object{object}
+  {
+    if(! object)
+    {
+      return;
+    }
+    if(transferType == TransferType::None)
+    {
+      gst_object_ref(object);
+    }
+    else if(transferType == TransferType::Floating)
+    {
+      gst_object_ref_sink(object);
+    }
+  }
+
+  ObjectRef(const ObjectRef& other)
+  : ObjectRef(other.object, TransferType::None)
+  {
+  }
+
+  ObjectRef(ObjectRef&& other) noexcept
+  : object{std::exchange(other.object, nullptr)}
+  {
+  }
+
+  ObjectRef& operator=(ObjectRef other) noexcept
+  {
+    std::swap(object, other.object);
+    return *this;
+  }
+
+  ~ObjectRef()
+  {
+    if(object)
+    {
+      gst_object_unref(object);
+    }
+  }
+
+  [[nodiscard]] T* get() const
+  {
+    return object;
+  }
+
+  T* operator->() const
+  {
+    return object;
+  }
+
+  explicit operator bool() const
+  {
+    return object != nullptr;
+  }
+
+  /**
+   * @brief Creates a shared_ptr (with its control block) referencing the same object.
+   */
+  [[nodiscard]] std::shared_ptr<T> toSharedPtr() const
+  {
+    return makeGstSharedPtr(object, TransferType::None);
+  }
+
+  friend bool operator==(const ObjectRef& a, const ObjectRef& b)
+  {
+    return a.object == b.object;
+  }
+
+  friend bool operator!=(const ObjectRef& a, const ObjectRef& b)
+  {
+    return a.object != b.object;
+  }
+
+private:
+  T* object{nullptr};
+};
+
+/**
+ * @brief Lazy single pass range over a GstIterator, e.g. for range based for loops.
+ * Items are fetched one by one while iterating, no container is built.
+ * If the underlying collection changes during the iteration (GST_ITERATOR_RESYNC), the iterator is resynced
+ * and the iteration starts again from the beginning, so items can be visited more than once. Callers who must
+ * not see duplicates compare @ref getResyncCount before and after each step.
+ * The range must outlive its iterators and must not be moved while iterating.
+ */
+template<typename T>
+class IteratorRange
+{
+  static_assert(IsGstObject<T>::value, "IteratorRange needs a GstObject type");
+
+public:
+  class Iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = ObjectRef<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const ObjectRef<T>*;
+    using reference = const ObjectRef<T>&;
+
+    /**
+     * @brief the end iterator
+     */
+    Iterator() = default;
+
+    reference operator*() const
+    {
+      return current;
+    }
+
+    pointer operator->() const
+    {
+      return &current;
+    }
+
+    /**
+     * @throws std::runtime_error if the GstIterator reports an error
+     */
+    Iterator& operator++()
+    {
+      current = range->next();
+      if(! current)
+      {
+        range = nullptr;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      Iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b)
+    {
+      return a.range == b.range && a.current == b.current;
+    }
+
+    friend bool operator!=(const Iterator& a, const Iterator& b)
+    {
+      return ! (a == b);
+    }
+
+  private:
+    friend class IteratorRange;
+
+    explicit Iterator(IteratorRange* range)
+    : range{range}
+    {
+      ++*this;
+    }
+
+    IteratorRange* range{nullptr};
+    ObjectRef<T> current;
+  };
+
+  /**
+   * @param iterator the GstIterator, transfer: full. nullptr results in an empty range
+   */
+  explicit IteratorRange(GstIterator* iterator)
+  : iterator{iterator}
+  {
+  }
+
+  IteratorRange(const IteratorRange&) = delete;
+  IteratorRange& operator=(const IteratorRange&) = delete;
+
+  IteratorRange(IteratorRange&& other) noexcept
+  : iterator{std::exchange(other.iterator, nullptr)}
+  , resyncCount{other.resyncCount}
+  {
+  }
+
+  IteratorRange& operator=(IteratorRange&& other) noexcept
+  {
+    std::swap(iterator, other.iterator);
+    std::swap(resyncCount, other.resyncCount);
+    return *this;
+  }
+
+  ~IteratorRange()
+  {
+    if(iterator)
+    {
+      gst_iterator_free(iterator);
+    }
+    g_value_unset(&value);
+  }
+
+  /**
+   * @brief Fetches the first item. Call it only once, the range is single pass.
+   * @throws std::runtime_error if the GstIterator reports an error
+   */
+  [[nodiscard]] Iterator begin()
+  {
+    return Iterator(this);
+  }
+
+  [[nodiscard]] Iterator end()
+  {
+    return Iterator();
+  }
+
+  /**
+   * @brief how often the iteration was restarted because the collection changed
+   */
+  [[nodiscard]] unsigned getResyncCount() const
+  {
+    return resyncCount;
+  }
+
+private:
+  ObjectRef<T> next()
+  {
+    while(iterator)
+    {
+      switch(gst_iterator_next(iterator, &value))
+      {
+        case GST_ITERATOR_OK:
+        {
+          ObjectRef<T> item(static_cast<T*>(g_value_get_object(&value)), TransferType::None);
+          g_value_reset(&value);
+          return item;
+        }
+        case GST_ITERATOR_RESYNC:
+          gst_iterator_resync(iterator);
+          ++resyncCount;
+          break;
+        case GST_ITERATOR_ERROR:
+          throw std::runtime_error("IteratorRange: error while iterating");
+        default:
+          return {};
+      }
+    }
+    return {};
+  }
+
+  GstIterator* iterator{nullptr};
+  GValue value = G_VALUE_INIT;
+  unsigned resyncCount{0};
+};
+
+using ElementRange = IteratorRange<GstElement>;
+using PadRange = IteratorRange<GstPad>;
+
+} // dh::gst
+
+#endif //DH_GST_ITERATORRANGE_HPP
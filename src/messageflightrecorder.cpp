@@ -0,0 +1,374 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "messageflightrecorder.hpp"
+#include "helpers.hpp"
+
+// std
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace dh::gst
+{
+
+namespace
+{
+void encodePayload(const GstMessage& message, std::uint64_t (&payload)[2])
+{
+  auto* messagePtr = const_cast<GstMessage*>(&message);
+  switch(GST_MESSAGE_TYPE(&message))
+  {
+    case GST_MESSAGE_STATE_CHANGED:
+    {
+      GstState oldState, newState, pendingState;
+      gst_message_parse_state_changed(messagePtr, &oldState, &newState, &pendingState);
+      payload[0] = static_cast<std::uint64_t>(oldState)
+        | static_cast<std::uint64_t>(newState) << 8
+        | static_cast<std::uint64_t>(pendingState) << 16;
+      break;
+    }
+    case GST_MESSAGE_ERROR:
+    case GST_MESSAGE_WARNING:
+    case GST_MESSAGE_INFO:
+    {
+      // gst_message_parse_error() copies the GError, so look at the field directly.
+      // "gerror" is the name GStreamer uses internally, it is not part of the API: parse the message if it is missing
+      static const GQuark errorQuark = g_quark_from_static_string("gerror");
+      const GstStructure* structure = gst_message_get_structure(messagePtr);
+      const GValue* errorValue = structure ? gst_structure_id_get_value(structure, errorQuark) : nullptr;
+      if(errorValue && G_VALUE_HOLDS(errorValue, G_TYPE_ERROR))
+      {
+        if(const auto* error = static_cast<const GError*>(g_value_get_boxed(errorValue)))
+        {
+          payload[0] = error->domain;
+          payload[1] = static_cast<std::uint32_t>(error->code);
+        }
+        break;
+      }
+
+      GError* error = nullptr;
+      if(GST_MESSAGE_TYPE(&message) == GST_MESSAGE_ERROR)
+      {
+        gst_message_parse_error(messagePtr, &error, nullptr);
+      }
+      else if(GST_MESSAGE_TYPE(&message) == GST_MESSAGE_WARNING)
+      {
+        gst_message_parse_warning(messagePtr, &error, nullptr);
+      }
+      else
+      {
+        gst_message_parse_info(messagePtr, &error, nullptr);
+      }
+      if(error)
+      {
+        payload[0] = error->domain;
+        payload[1] = static_cast<std::uint32_t>(error->code);
+        g_error_free(error);
+      }
+      break;
+    }
+    case GST_MESSAGE_QOS:
+    {
+      gint64 jitter;
+      gdouble proportion;
+      gint quality;
+      gst_message_parse_qos_values(messagePtr, &jitter, &proportion, &quality);
+      GstFormat format;
+      guint64 processed;
+      guint64 dropped;
+      gst_message_parse_qos_stats(messagePtr, &format, &processed, &dropped);
+      payload[0] = static_cast<std::uint64_t>(jitter);
+      payload[1] = dropped;
+      break;
+    }
+    case GST_MESSAGE_BUFFERING:
+    {
+      gint percent;
+      gst_message_parse_buffering(messagePtr, &percent);
+      payload[0] = static_cast<std::uint64_t>(percent);
+      break;
+    }
+    case GST_MESSAGE_ASYNC_DONE:
+    {
+      GstClockTime runningTime;
+      gst_message_parse_async_done(messagePtr, &runningTime);
+      payload[0] = runningTime;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void describePayload(std::ostream& stream, const MessageFlightRecorder::Entry& entry)
+{
+  switch(entry.type)
+  {
+    case GST_MESSAGE_STATE_CHANGED:
+      stream << ' ' << gst_element_state_get_name(static_cast<GstState>(entry.payload[0] & 0xff))
+             << " -> " << gst_element_state_get_name(static_cast<GstState>((entry.payload[0] >> 8) & 0xff))
+             << " (pending " << gst_element_state_get_name(static_cast<GstState>((entry.payload[0] >> 16) & 0xff)) << ')';
+      break;
+    case GST_MESSAGE_ERROR:
+    case GST_MESSAGE_WARNING:
+    case GST_MESSAGE_INFO:
+    {
+      const gchar* domain = entry.payload[0] ? g_quark_to_string(static_cast<GQuark>(entry.payload[0])) : nullptr;
+      stream << ' ' << (domain ? domain : "unknown") << ':' << static_cast<gint>(entry.payload[1]);
+      break;
+    }
+    case GST_MESSAGE_QOS:
+      stream << " jitter " << static_cast<gint64>(entry.payload[0]) << " dropped " << entry.payload[1];
+      break;
+    case GST_MESSAGE_BUFFERING:
+      stream << ' ' << entry.payload[0] << '%';
+      break;
+    case GST_MESSAGE_ASYNC_DONE:
+      stream << " running time " << entry.payload[0];
+      break;
+    default:
+      break;
+  }
+}
+} // namespace
+
+class MessageFlightRecorder::Private
+{
+public:
+  // the entry in atomic words, so readers racing with a writer are no data race
+  struct Slot
+  {
+    std::atomic<std::uint64_t> sequence{0}; // odd while written, 2 * (index + 1) when complete
+    std::atomic<std::uint64_t> timestamp{0};
+    std::atomic<std::uint64_t> typeAndSource{0};
+    std::atomic<std::uint64_t> seqnum{0};
+    std::atomic<std::uint64_t> payload[2]{};
+  };
+
+  struct Attachment
+  {
+    GstBusSPtr bus;
+    gulong handlerId;
+  };
+
+  explicit Private(std::size_t capacity)
+  : slots(capacity)
+  , mask{capacity - 1}
+  {
+  }
+
+  std::vector<Slot> slots;
+  const std::size_t mask;
+  std::atomic<std::uint64_t> head{0};
+  std::atomic<bool> dumpOnError{false};
+
+  std::mutex attachmentMutex;
+  std::vector<Attachment> attachments;
+
+  void record(const GstMessage& message)
+  {
+    std::uint64_t payload[2]{0, 0};
+    encodePayload(message, payload);
+    const auto type = static_cast<std::uint64_t>(static_cast<guint>(GST_MESSAGE_TYPE(&message)));
+    const auto source = static_cast<std::uint64_t>(helpers::getObjectNameQuark(GST_MESSAGE_SRC(&message)));
+
+    const std::uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[index & mask];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestamp.store(gst_util_get_timestamp(), std::memory_order_relaxed);
+    slot.typeAndSource.store(type | source << 32, std::memory_order_relaxed);
+    slot.seqnum.store(GST_MESSAGE_SEQNUM(&message), std::memory_order_relaxed);
+    slot.payload[0].store(payload[0], std::memory_order_relaxed);
+    slot.payload[1].store(payload[1], std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+
+    if(GST_MESSAGE_TYPE(&message) == GST_MESSAGE_ERROR && dumpOnError.load(std::memory_order_relaxed))
+    {
+      try
+      {
+        dumpToLog();
+      }
+      catch(const std::exception& e)
+      {
+        GST_ERROR("MessageFlightRecorder: dump failed: %s", e.what());
+      }
+    }
+  }
+
+  std::vector<Entry> snapshot() const
+  {
+    const std::uint64_t end = head.load(std::memory_order_acquire);
+    const std::uint64_t begin = end > slots.size() ? end - slots.size() : 0;
+    std::vector<Entry> entries;
+    entries.reserve(static_cast<std::size_t>(end - begin));
+    for(std::uint64_t index = begin; index < end; ++index)
+    {
+      const Slot& slot = slots[index & mask];
+      const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if(sequence != 2 * index + 2)
+      {
+        // still written or already overwritten
+        continue;
+      }
+      const std::uint64_t typeAndSource = slot.typeAndSource.load(std::memory_order_relaxed);
+      Entry entry{
+        index,
+        slot.timestamp.load(std::memory_order_relaxed),
+        static_cast<GstMessageType>(typeAndSource & 0xffffffff),
+        static_cast<GQuark>(typeAndSource >> 32),
+        static_cast<guint32>(slot.seqnum.load(std::memory_order_relaxed)),
+        {slot.payload[0].load(std::memory_order_relaxed), slot.payload[1].load(std::memory_order_relaxed)}
+      };
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if(slot.sequence.load(std::memory_order_relaxed) != sequence)
+      {
+        continue;
+      }
+      entries.push_back(entry);
+    }
+    return entries;
+  }
+
+  void dump(std::ostream& stream) const
+  {
+    for(const auto& entry : snapshot())
+    {
+      const gchar* source = entry.source ? g_quark_to_string(entry.source) : nullptr;
+      stream << '#' << entry.index
+             << ' ' << entry.timestamp
+             << ' ' << gst_message_type_get_name(entry.type)
+             << " from '" << (source ? source : "unknown") << '\''
+             << " seqnum " << entry.seqnum;
+      describePayload(stream, entry);
+      stream << '\n';
+    }
+  }
+
+  void dumpToLog() const
+  {
+    std::ostringstream stream;
+    dump(stream);
+    std::istringstream lines(stream.str());
+    GST_ERROR("MessageFlightRecorder: error message recorded, last messages:");
+    for(std::string line; std::getline(lines, line);)
+    {
+      GST_ERROR("MessageFlightRecorder: %s", line.c_str());
+    }
+  }
+
+  static void onSyncMessage(GstBus* /*bus*/, GstMessage* message, gpointer userData)
+  {
+    (*static_cast<std::shared_ptr<Private>*>(userData))->record(*message);
+  }
+
+  static void destroyHandlerData(gpointer userData, GClosure* /*closure*/)
+  {
+    delete static_cast<std::shared_ptr<Private>*>(userData);
+  }
+};
+
+MessageFlightRecorder::MessageFlightRecorder(std::size_t capacity)
+{
+  if(capacity == 0)
+  {
+    throw std::invalid_argument("MessageFlightRecorder: capacity must not be 0");
+  }
+  std::size_t roundedCapacity = 1;
+  while(roundedCapacity < capacity)
+  {
+    roundedCapacity <<= 1;
+  }
+  prv = std::make_shared<Private>(roundedCapacity);
+}
+
+MessageFlightRecorder::~MessageFlightRecorder()
+{
+  std::lock_guard lock(prv->attachmentMutex);
+  for(const auto& attachment : prv->attachments)
+  {
+    // a handler running right now keeps its own reference to prv
+    g_signal_handler_disconnect(attachment.bus.get(), attachment.handlerId);
+    gst_bus_disable_sync_message_emission(attachment.bus.get());
+  }
+}
+
+std::shared_ptr<MessageFlightRecorder> MessageFlightRecorder::create(std::size_t capacity)
+{
+  return std::shared_ptr<MessageFlightRecorder>(new MessageFlightRecorder(capacity));
+}
+
+void MessageFlightRecorder::attach(const std::shared_ptr<Bus>& bus)
+{
+  if(! bus)
+  {
+    throw std::invalid_argument("MessageFlightRecorder: no bus given");
+  }
+  auto gstBus = bus->getGstBus();
+  gst_bus_enable_sync_message_emission(gstBus.get());
+  // a raw GObject handler, boost signals would lock a mutex for each message
+  const gulong handlerId = g_signal_connect_data(
+    gstBus.get(),
+    "sync-message",
+    G_CALLBACK(&Private::onSyncMessage),
+    new std::shared_ptr<Private>(prv),
+    &Private::destroyHandlerData,
+    static_cast<GConnectFlags>(0)
+  );
+
+  std::lock_guard lock(prv->attachmentMutex);
+  prv->attachments.push_back({std::move(gstBus), handlerId});
+}
+
+void MessageFlightRecorder::record(const GstMessage& message) noexcept
+{
+  prv->record(message);
+}
+
+std::vector<MessageFlightRecorder::Entry> MessageFlightRecorder::snapshot() const
+{
+  return prv->snapshot();
+}
+
+void MessageFlightRecorder::dump(std::ostream& stream) const
+{
+  prv->dump(stream);
+}
+
+void MessageFlightRecorder::setDumpOnError(bool dumpOnError)
+{
+  prv->dumpOnError = dumpOnError;
+}
+
+std::size_t MessageFlightRecorder::getCapacity() const
+{
+  return prv->slots.size();
+}
+
+std::uint64_t MessageFlightRecorder::getRecordedCount() const
+{
+  return prv->head.load(std::memory_order_relaxed);
+}
+
+} // dh::gst
@@ -0,0 +1,128 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_MESSAGEFLIGHTRECORDER_HPP
+#define DH_GST_MESSAGEFLIGHTRECORDER_HPP
+
+// local includes
+#include "bus.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+// C
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Records compact entries of all bus messages into a fixed size ring buffer, so the last messages
+ * before a failure can be dumped without keeping GST_DEBUG logging enabled.
+ * Recording takes no locks and does not allocate: each slot is protected by a sequence counter,
+ * readers skip slots that are overwritten while they read them.
+ * The source name is stored as quark, cached on the source object after its first message.
+ */
+class MessageFlightRecorder
+{
+protected:
+  /**
+   * @brief Create a recorder
+   * @param capacity number of entries, rounded up to a power of two
+   * @throws std::invalid_argument if capacity is 0
+   */
+  explicit MessageFlightRecorder(std::size_t capacity);
+
+public:
+  struct Entry
+  {
+    std::uint64_t index;    ///< number of the recorded message since creation
+    GstClockTime timestamp; ///< monotonic time (gst_util_get_timestamp) of the recording
+    GstMessageType type;
+    GQuark source;          ///< name of the source object, 0 if there is none
+    guint32 seqnum;         ///< GST_MESSAGE_SEQNUM
+    /**
+     * STATE_CHANGED: old | new << 8 | pending << 16, -
+     * ERROR, WARNING, INFO: GError domain, GError code
+     * QOS: jitter (gint64), dropped
+     * BUFFERING: percent, -
+     * ASYNC_DONE: running time, -
+     */
+    std::uint64_t payload[2];
+  };
+
+  [[nodiscard]] static std::shared_ptr<MessageFlightRecorder> create(std::size_t capacity = 4096);
+
+  /**
+   * @brief detaches from all buses
+   */
+  ~MessageFlightRecorder();
+
+  /**
+   * @brief Record all messages posted on the bus, from the posting thread.
+   * Enables the sync message emission of the bus.
+   * @param bus the bus
+   * @throws std::invalid_argument if bus is empty
+   */
+  void attach(const std::shared_ptr<Bus>& bus);
+
+  /**
+   * @brief Record one message. Can be called from any thread, e.g. from an own bus sync handler.
+   * @param message the message
+   */
+  void record(const GstMessage& message) noexcept;
+
+  /**
+   * @brief Get the recorded entries, oldest first.
+   * @return up to capacity entries
+   */
+  [[nodiscard]] std::vector<Entry> snapshot() const;
+
+  /**
+   * @brief Write the recorded entries in human readable form, one line each, oldest first.
+   * @param stream the stream to write to
+   */
+  void dump(std::ostream& stream) const;
+
+  /**
+   * @brief Dump the entries with GST_ERROR when an ERROR message is recorded. Default: false
+   * @param dumpOnError true to enable
+   */
+  void setDumpOnError(bool dumpOnError);
+
+  [[nodiscard]] std::size_t getCapacity() const;
+
+  /**
+   * @brief Get the number of messages recorded since creation, including the overwritten ones.
+   */
+  [[nodiscard]] std::uint64_t getRecordedCount() const;
+
+private:
+  class Private;
+  std::shared_ptr<Private> prv; // shared with the signal handlers
+};
+
+} // dh::gst
+
+#endif //DH_GST_MESSAGEFLIGHTRECORDER_HPP
@@ -19,14 +19,192 @@
  */
 
 #include "messageparser.hpp"
+#include "busmetrics.hpp"
+#include "helpers.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
 
 namespace dh::gst
 {
 
+namespace
+{
+/**
+ * @brief Owns the copies made by the gst_message_parse_*() fallbacks, keep it until the record is emitted.
+ */
+struct ParsedCopies
+{
+  ParsedCopies() = default;
+  ParsedCopies(const ParsedCopies&) = delete;
+  ParsedCopies& operator=(const ParsedCopies&) = delete;
+
+  ~ParsedCopies()
+  {
+    g_clear_error(&error);
+    g_free(first);
+    g_free(second);
+  }
+
+  GError* error{nullptr};
+  gchar* first{nullptr};
+  gchar* second{nullptr};
+};
+
+/**
+ * @brief Build the record directly from the message structure.
+ * gst_message_parse_error() and friends return copies of the GError and the debug string, we only need to look.
+ * This relies on the field names GStreamer uses internally ("gerror" and "debug"), which are not part of the API.
+ * If a field is missing, the record is built with gst_message_parse_error() and friends, the copies are kept in copies.
+ */
+TextMessageRecord makeTextMessageRecord(const GstMessage& message, std::string_view sourceName, ParsedCopies& copies)
+{
+  static const GQuark errorQuark = g_quark_from_static_string("gerror");
+  static const GQuark debugQuark = g_quark_from_static_string("debug");
+
+  const GValue* errorValue = nullptr;
+  const GValue* debugValue = nullptr;
+  if(const GstStructure* structure = gst_message_get_structure(const_cast<GstMessage*>(&message)))
+  {
+    errorValue = gst_structure_id_get_value(structure, errorQuark);
+    debugValue = gst_structure_id_get_value(structure, debugQuark);
+  }
+
+  const GError* error = nullptr;
+  const gchar* debugInfo = nullptr;
+  if(errorValue && G_VALUE_HOLDS(errorValue, G_TYPE_ERROR) && debugValue && G_VALUE_HOLDS_STRING(debugValue))
+  {
+    error = static_cast<const GError*>(g_value_get_boxed(errorValue));
+    debugInfo = g_value_get_string(debugValue);
+  }
+  else
+  {
+    auto* gstMessage = const_cast<GstMessage*>(&message);
+    switch(GST_MESSAGE_TYPE(&message))
+    {
+      case GST_MESSAGE_ERROR:
+        gst_message_parse_error(gstMessage, &copies.error, &copies.first);
+        break;
+      case GST_MESSAGE_WARNING:
+        gst_message_parse_warning(gstMessage, &copies.error, &copies.first);
+        break;
+      case GST_MESSAGE_INFO:
+        gst_message_parse_info(gstMessage, &copies.error, &copies.first);
+        break;
+      default:
+        break;
+    }
+    error = copies.error;
+    debugInfo = copies.first;
+  }
+
+  return TextMessageRecord{
+    {message, sourceName},
+    error && error->message ? error->message : "",
+    debugInfo ? debugInfo : "",
+    error ? error->domain : 0,
+    error ? error->code : 0
+  };
+}
+
+/**
+ * @brief gst_message_parse_progress() returns copies of code and text, read them from the structure instead.
+ * Like @ref makeTextMessageRecord this relies on the internal field names ("type", "code" and "text")
+ * and falls back to gst_message_parse_progress() if one is missing.
+ */
+ProgressRecord makeProgressRecord(const GstMessage& message, std::string_view sourceName, ParsedCopies& copies)
+{
+  static const GQuark typeQuark = g_quark_from_static_string("type");
+  static const GQuark codeQuark = g_quark_from_static_string("code");
+  static const GQuark textQuark = g_quark_from_static_string("text");
+
+  ProgressRecord record{{message, sourceName}, GST_PROGRESS_TYPE_START, "", ""};
+  const GValue* typeValue = nullptr;
+  const GValue* codeValue = nullptr;
+  const GValue* textValue = nullptr;
+  if(const GstStructure* structure = gst_message_get_structure(const_cast<GstMessage*>(&message)))
+  {
+    typeValue = gst_structure_id_get_value(structure, typeQuark);
+    codeValue = gst_structure_id_get_value(structure, codeQuark);
+    textValue = gst_structure_id_get_value(structure, textQuark);
+  }
+
+  if(typeValue && G_VALUE_HOLDS_ENUM(typeValue)
+    && codeValue && G_VALUE_HOLDS_STRING(codeValue)
+    && textValue && G_VALUE_HOLDS_STRING(textValue))
+  {
+    record.type = static_cast<GstProgressType>(g_value_get_enum(typeValue));
+    if(g_value_get_string(codeValue))
+    {
+      record.code = g_value_get_string(codeValue);
+    }
+    if(g_value_get_string(textValue))
+    {
+      record.text = g_value_get_string(textValue);
+    }
+    return record;
+  }
+
+  gst_message_parse_progress(const_cast<GstMessage*>(&message), &record.type, &copies.first, &copies.second);
+  if(copies.first)
+  {
+    record.code = copies.first;
+  }
+  if(copies.second)
+  {
+    record.text = copies.second;
+  }
+  return record;
+}
+
+using TextSignal = bs2::signal<void(const std::string&, const std::string&, const std::string&)>;
+using TextRecordSignal = bs2::signal<void(const TextMessageRecord&)>;
+
+void emitTextMessage(const TextMessageRecord& record, TextRecordSignal& recordSignal, TextSignal& textSignal)
+{
+  recordSignal(record);
+  if(! textSignal.empty())
+  {
+    textSignal(std::string(record.sourceName), std::string(record.text), std::string(record.debugInfo));
+  }
+}
+} // namespace
+
 class MessageParser::Private
 {
 public:
+  struct Pending
+  {
+    GstMessage* message; // own reference
+    GstClockTime queued;
+  };
+
+  ~Private()
+  {
+    for(const auto& entry : pending)
+    {
+      gst_message_unref(entry.message);
+    }
+  }
+
   MessageParser::AsyncHandler asyncHandler;
+
+  std::mutex mutex;
+  std::vector<Pending> pending;
+  std::vector<Pending> batch; // only used by the drain task, swapped with pending to reuse the memory
+  std::size_t maxBatchSize{0};
+  bool drainScheduled{false};
+  std::shared_ptr<MessageParser> scheduledSelf; // keeps the parser alive while a drain task is posted
+  AsyncStats stats;
+  std::shared_ptr<BusMetrics> metrics;
+
+  std::mutex slotMutex;
+  std::map<GstMessageType, unsigned> slotCounts; // connected slots per type, guarded by slotMutex
+  std::atomic<guint> interestMask{GST_MESSAGE_UNKNOWN};
 };
 
 MessageParser::MessageParser()
@@ -38,69 +216,188 @@ MessageParser::~MessageParser() = default;
 
 void MessageParser::parse(const GstMessage& message)
 {
-  if(prv->asyncHandler)
+  if(prv->metrics)
   {
-    // keep the message alive until processed
-    gst_message_ref(const_cast<GstMessage*>(&message));
-    prv->asyncHandler(
-      [this, &message]()
-      {
-        parseSync(message);
-        gst_message_unref(const_cast<GstMessage*>(&message));
-      }
-    );
+    prv->metrics->countMessage(message);
   }
-  else
+
+  if(! isObserved(GST_MESSAGE_TYPE(&message)))
+  {
+    GST_LOG("MessageParser: ignoring unobserved message type '%s'", GST_MESSAGE_TYPE_NAME(&message));
+    return;
+  }
+
+  if(! prv->asyncHandler)
   {
     parseSync(message);
+    return;
+  }
+
+  bool postTask = false;
+  {
+    std::lock_guard lock(prv->mutex);
+    // keep the message alive until processed
+    prv->pending.push_back({gst_message_ref(const_cast<GstMessage*>(&message)), gst_util_get_timestamp()});
+    if(! prv->drainScheduled)
+    {
+      prv->drainScheduled = true;
+      prv->scheduledSelf = shared_from_this();
+      postTask = true;
+    }
+  }
+  if(postTask)
+  {
+    postDrainTask();
   }
-  parseSync(message);
 }
 
+void MessageParser::postDrainTask()
+{
+  // a raw pointer fits into the small buffer of std::function, posting does not allocate.
+  // scheduledSelf keeps the parser alive until the task runs.
+  prv->asyncHandler(
+    [parser = this]()
+    {
+      parser->drainPending();
+    }
+  );
+}
+
+void MessageParser::drainPending()
+{
+  std::shared_ptr<MessageParser> keepAlive;
+  {
+    std::lock_guard lock(prv->mutex);
+    keepAlive = std::move(prv->scheduledSelf);
+    if(prv->maxBatchSize == 0 || prv->pending.size() <= prv->maxBatchSize)
+    {
+      std::swap(prv->batch, prv->pending);
+    }
+    else
+    {
+      const auto end = prv->pending.begin() + static_cast<std::ptrdiff_t>(prv->maxBatchSize);
+      prv->batch.assign(prv->pending.begin(), end);
+      prv->pending.erase(prv->pending.begin(), end);
+    }
+  }
+
+  GstClockTime maxLatency = 0;
+  GstClockTime totalLatency = 0;
+  GstClockTime lastLatency = 0;
+  for(const auto& entry : prv->batch)
+  {
+    const GstClockTime now = gst_util_get_timestamp();
+    lastLatency = now > entry.queued ? now - entry.queued : 0;
+    maxLatency = std::max(maxLatency, lastLatency);
+    totalLatency += lastLatency;
+    try
+    {
+      parseSync(*entry.message);
+    }
+    catch(const std::exception& e)
+    {
+      GST_ERROR("MessageParser: slot for '%s' threw: %s", GST_MESSAGE_TYPE_NAME(entry.message), e.what());
+    }
+    gst_message_unref(entry.message);
+  }
+  const std::size_t handled = prv->batch.size();
+  prv->batch.clear();
+
+  bool postTask = false;
+  {
+    std::lock_guard lock(prv->mutex);
+    prv->stats.messages += handled;
+    ++prv->stats.batches;
+    prv->stats.lastQueueLatency = lastLatency;
+    prv->stats.maxQueueLatency = std::max(prv->stats.maxQueueLatency, maxLatency);
+    prv->stats.totalQueueLatency += totalLatency;
+
+    if(prv->pending.empty())
+    {
+      prv->drainScheduled = false;
+    }
+    else
+    {
+      prv->scheduledSelf = keepAlive;
+      postTask = true;
+    }
+  }
+  if(postTask)
+  {
+    postDrainTask();
+  }
+}
+
+void MessageParser::setMaxBatchSize(std::size_t maxBatchSize)
+{
+  std::lock_guard lock(prv->mutex);
+  prv->maxBatchSize = maxBatchSize;
+}
+
+void MessageParser::setMetrics(std::shared_ptr<BusMetrics> metrics)
+{
+  prv->metrics = std::move(metrics);
+}
+
+MessageParser::AsyncStats MessageParser::getAsyncStats() const
+{
+  std::lock_guard lock(prv->mutex);
+  return prv->stats;
+}
+
+void MessageParser::resetAsyncStats()
+{
+  std::lock_guard lock(prv->mutex);
+  prv->stats = {};
+}
 
 void MessageParser::parseSync(const GstMessage& message)
 {
-  const std::string sourceName = getSourceName(message);
+  // slots can be disconnected while an async parse is pending
+  if(! isObserved(GST_MESSAGE_TYPE(&message)))
+  {
+    return;
+  }
+
+  // the slots measure themselves, see ParserSignal
+  emitSignals(message);
+}
+
+void MessageParser::emitSignals(const GstMessage& message)
+{
+  const std::string_view sourceName = getSourceName(message);
   auto* messagePtr = const_cast<GstMessage*>(&message);
 
   switch (GST_MESSAGE_TYPE(&message))
   {
     case GST_MESSAGE_EOS:
     {
-      endOfStreamSignal(sourceName);
+      endOfStreamRecordSignal(MessageRecord{message, sourceName});
+      if(! endOfStreamSignal.empty())
+      {
+        endOfStreamSignal(std::string(sourceName));
+      }
       break;
     }
 
     case GST_MESSAGE_ERROR:
     {
-      GError* error = nullptr;
-      gchar* debugInfo = nullptr;
-      gst_message_parse_error(messagePtr, &error, &debugInfo);
-      errorSignal(sourceName, error->message, debugInfo ? debugInfo : "");
-      g_clear_error(&error);
-      g_free(debugInfo);
+      ParsedCopies copies;
+      emitTextMessage(makeTextMessageRecord(message, sourceName, copies), errorRecordSignal, errorSignal);
       break;
     }
 
     case GST_MESSAGE_WARNING:
     {
-      GError* warning = nullptr;
-      gchar* debugInfo = nullptr;
-      gst_message_parse_warning(messagePtr, &warning, &debugInfo);
-      warningSignal(sourceName, warning->message, debugInfo ? debugInfo : "");
-      g_clear_error(&warning);
-      g_free(debugInfo);
+      ParsedCopies copies;
+      emitTextMessage(makeTextMessageRecord(message, sourceName, copies), warningRecordSignal, warningSignal);
       break;
     }
 
     case GST_MESSAGE_INFO:
     {
-      GError* info = nullptr;
-      gchar* debugInfo = nullptr;
-      gst_message_parse_info(messagePtr, &info, &debugInfo);
-      infoSignal(sourceName, info->message, debugInfo ? debugInfo : "");
-      g_clear_error(&info);
-      g_free(debugInfo);
+      ParsedCopies copies;
+      emitTextMessage(makeTextMessageRecord(message, sourceName, copies), infoRecordSignal, infoSignal);
       break;
     }
 
@@ -108,13 +405,21 @@ void MessageParser::parseSync(const GstMessage& message)
     {
       GstState oldState, newState, pendingState;
       gst_message_parse_state_changed(messagePtr, &oldState, &newState, &pendingState);
-      stateChangedSignal(sourceName, oldState, newState, pendingState);
+      stateChangedRecordSignal(StateChangedRecord{{message, sourceName}, oldState, newState, pendingState});
+      if(! stateChangedSignal.empty())
+      {
+        stateChangedSignal(std::string(sourceName), oldState, newState, pendingState);
+      }
       break;
     }
 
     case GST_MESSAGE_DURATION_CHANGED:
     {
-      durationChangedSignal(sourceName);
+      durationChangedRecordSignal(MessageRecord{message, sourceName});
+      if(! durationChangedSignal.empty())
+      {
+        durationChangedSignal(std::string(sourceName));
+      }
       break;
     }
 
@@ -123,21 +428,33 @@ void MessageParser::parseSync(const GstMessage& message)
       GstStreamStatusType statusType;
       GstElement* ownerElement;
       gst_message_parse_stream_status(messagePtr, &statusType, &ownerElement);
-      std::string ownerName = ownerElement ? GST_OBJECT_NAME(ownerElement) : "unknown";
-      streamStatusSignal(sourceName, statusType, ownerName);
+      const std::string_view ownerName = ownerElement && GST_OBJECT_NAME(ownerElement) ? GST_OBJECT_NAME(ownerElement) : "unknown";
+      streamStatusRecordSignal(StreamStatusRecord{{message, sourceName}, statusType, ownerName});
+      if(! streamStatusSignal.empty())
+      {
+        streamStatusSignal(std::string(sourceName), statusType, std::string(ownerName));
+      }
       break;
     }
 
     case GST_MESSAGE_STREAM_START:
     {
-      streamStartSignal(sourceName);
+      streamStartRecordSignal(MessageRecord{message, sourceName});
+      if(! streamStartSignal.empty())
+      {
+        streamStartSignal(std::string(sourceName));
+      }
       break;
     }
 
     case GST_MESSAGE_ELEMENT:
     {
       const GstStructure* structure = gst_message_get_structure(messagePtr);
-      elementMessageSignal(sourceName, structure);
+      elementMessageRecordSignal(ElementMessageRecord{{message, sourceName}, structure});
+      if(! elementMessageSignal.empty())
+      {
+        elementMessageSignal(std::string(sourceName), structure);
+      }
       break;
     }
 
@@ -145,18 +462,108 @@ void MessageParser::parseSync(const GstMessage& message)
     {
       GstClockTime runningTime;
       gst_message_parse_async_done(messagePtr, &runningTime);
-      asyncDoneSignal(sourceName, runningTime);
+      asyncDoneRecordSignal(AsyncDoneRecord{{message, sourceName}, runningTime});
+      if(! asyncDoneSignal.empty())
+      {
+        asyncDoneSignal(std::string(sourceName), runningTime);
+      }
+      break;
+    }
+
+    case GST_MESSAGE_QOS:
+    {
+      QosRecord record{{message, sourceName}};
+      gboolean live;
+      gst_message_parse_qos(messagePtr, &live, &record.runningTime, &record.streamTime, &record.timestamp, &record.duration);
+      record.live = live;
+      gst_message_parse_qos_values(messagePtr, &record.jitter, &record.proportion, &record.quality);
+      gst_message_parse_qos_stats(messagePtr, &record.format, &record.processed, &record.dropped);
+      qosRecordSignal(record);
+      break;
+    }
+
+    case GST_MESSAGE_LATENCY:
+    {
+      latencyRecordSignal(MessageRecord{message, sourceName});
+      break;
+    }
+
+    case GST_MESSAGE_BUFFERING:
+    {
+      BufferingRecord record{{message, sourceName}};
+      gst_message_parse_buffering(messagePtr, &record.percent);
+      gst_message_parse_buffering_stats(messagePtr, &record.mode, &record.averageIn, &record.averageOut, &record.bufferingLeft);
+      bufferingRecordSignal(record);
+      break;
+    }
+
+    case GST_MESSAGE_PROGRESS:
+    {
+      ParsedCopies copies;
+      progressRecordSignal(makeProgressRecord(message, sourceName, copies));
       break;
     }
 
     // Add more message types as needed...
 
     default:
-      GST_WARNING("MessageParser: Unhandled message type '%s'", GST_MESSAGE_TYPE_NAME(messagePtr));
-      //throw std::runtime_error("Unsupported message type: " + std::string(GST_MESSAGE_TYPE_NAME(messagePtr)));
+      // not reached, isObserved() is false for unhandled types
+      break;
   }
 }
 
+bool MessageParser::isObserved(GstMessageType type) const
+{
+  // extended types reuse the bits of e.g. EOS or ERROR, they are never observed
+  return helpers::isMessageTypeInMask(type, static_cast<GstMessageType>(prv->interestMask.load(std::memory_order_relaxed)));
+}
+
+void MessageParser::addObservedSlot(GstMessageType type)
+{
+  guint mask;
+  {
+    std::lock_guard lock(prv->slotMutex);
+    if(prv->slotCounts[type]++ != 0)
+    {
+      return;
+    }
+    mask = prv->interestMask |= type;
+  }
+  interestMaskChangedSignal(static_cast<GstMessageType>(mask));
+}
+
+void MessageParser::removeObservedSlot(GstMessageType type)
+{
+  guint mask;
+  {
+    std::lock_guard lock(prv->slotMutex);
+    if(--prv->slotCounts[type] != 0)
+    {
+      return;
+    }
+    mask = prv->interestMask &= ~static_cast<guint>(type);
+  }
+  interestMaskChangedSignal(static_cast<GstMessageType>(mask));
+}
+
+bool MessageParser::hasMetrics() const
+{
+  return prv->metrics != nullptr;
+}
+
+void MessageParser::recordSlotDuration(const std::string& slotName, GstMessageType type, GstClockTime duration)
+{
+  if(prv->metrics)
+  {
+    prv->metrics->recordHandlerDuration(slotName, type, duration);
+  }
+}
+
+GstMessageType MessageParser::getInterestMask() const
+{
+  return static_cast<GstMessageType>(prv->interestMask.load(std::memory_order_relaxed));
+}
+
 std::shared_ptr<MessageParser> MessageParser::create()
 {
   return std::shared_ptr<MessageParser>(new MessageParser());
@@ -169,7 +576,7 @@ std::shared_ptr<MessageParser> MessageParser::create(AsyncHandler handler)
   return ret;
 }
 
-std::string MessageParser::getSourceName(const GstMessage& message) const
+std::string_view MessageParser::getSourceName(const GstMessage& message)
 {
   if(GST_MESSAGE_SRC(&message))
   {
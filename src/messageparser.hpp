@@ -23,7 +23,13 @@
 
 #include <boost/signals2.hpp>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 
 #include <gst/gst.h>
@@ -33,20 +39,163 @@ namespace bs2 = boost::signals2;
 namespace dh::gst
 {
 
+class BusMetrics;
+
+/**
+ * @brief Data shared by all typed message records.
+ * Records only reference the parsed GstMessage, nothing is copied. They are valid during the signal emission only.
+ * To keep data, copy it or take a reference of the message.
+ */
+struct MessageRecord
+{
+  const GstMessage& message;
+  std::string_view sourceName; ///< name of the source object or "unknown"
+};
+
+/**
+ * @brief record of an ERROR, WARNING or INFO message.
+ */
+struct TextMessageRecord : MessageRecord
+{
+  std::string_view text;      ///< the GError message
+  std::string_view debugInfo; ///< empty if the message has no debug info
+  GQuark domain;              ///< the GError domain, e.g. GST_STREAM_ERROR
+  gint code;                  ///< the GError code within the domain
+};
+
+struct StateChangedRecord : MessageRecord
+{
+  GstState oldState;
+  GstState newState;
+  GstState pendingState;
+};
+
+struct StreamStatusRecord : MessageRecord
+{
+  GstStreamStatusType statusType;
+  std::string_view ownerName; ///< name of the element owning the streaming thread or "unknown"
+};
+
+struct ElementMessageRecord : MessageRecord
+{
+  const GstStructure* structure;
+};
+
+struct AsyncDoneRecord : MessageRecord
+{
+  GstClockTime runningTime;
+};
+
+/**
+ * @brief record of a QOS message, see gst_message_parse_qos, gst_message_parse_qos_values and gst_message_parse_qos_stats.
+ */
+struct QosRecord : MessageRecord
+{
+  bool live{};
+  guint64 runningTime{};
+  guint64 streamTime{};
+  guint64 timestamp{};
+  guint64 duration{};
+  gint64 jitter{};      ///< difference of the running time to the desired running time, positive if too late
+  gdouble proportion{}; ///< requested processing rate, 1.0 is normal
+  gint quality{};
+  GstFormat format{};   ///< format of processed and dropped
+  guint64 processed{};
+  guint64 dropped{};
+};
+
+struct BufferingRecord : MessageRecord
+{
+  gint percent{};
+  GstBufferingMode mode{};
+  gint averageIn{};       ///< bytes per second
+  gint averageOut{};      ///< bytes per second
+  gint64 bufferingLeft{}; ///< milliseconds
+};
+
+struct ProgressRecord : MessageRecord
+{
+  GstProgressType type;
+  std::string_view code;
+  std::string_view text;
+};
+
+class MessageParser;
+
+/**
+ * @brief boost::signals2::signal of the MessageParser which tells the parser when slots are connected and released.
+ * So the parser keeps a mask of the observed message types and does not inspect its signals for every message.
+ * With metrics (see @ref MessageParser::setMetrics) the duration of each slot is recorded under the name of the slot.
+ * Connect through this type: slots connected via a reference to the boost::signals2::signal base are not seen.
+ */
+template<typename Signature>
+class ParserSignal;
+
+template<typename... Args>
+class ParserSignal<void(Args...)> : public bs2::signal<void(Args...)>
+{
+  using Base = bs2::signal<void(Args...)>;
+
+public:
+  using slot_type = typename Base::slot_type;
+  using group_type = typename Base::group_type;
+
+  ParserSignal(MessageParser& parser, GstMessageType messageType, std::string name);
+
+  /**
+   * @brief Connect a slot, its durations are recorded as "<signal name>#<number of the connection>".
+   */
+  bs2::connection connect(const slot_type& slot, bs2::connect_position position = bs2::at_back);
+  bs2::connection connect(const group_type& group, const slot_type& slot, bs2::connect_position position = bs2::at_back);
+
+  /**
+   * @brief Connect a slot, its durations are recorded as slotName, e.g. to find it in the reports of slow handlers.
+   */
+  bs2::connection connectNamed(std::string slotName, const slot_type& slot, bs2::connect_position position = bs2::at_back);
+
+  /// not supported, the slots would not be seen by the parser
+  template<typename... T>
+  bs2::connection connect_extended(T&&...) = delete;
+
+private:
+  slot_type wrap(const slot_type& slot, std::string slotName);
+
+  MessageParser& parser;
+  const GstMessageType messageType;
+  const std::string name;
+  std::atomic<unsigned> connectionCount{0};
+};
+
 /**
  * @brief parser for GstMessages. After parsing, the matching signal is emitted.
  */
-class MessageParser
+class MessageParser : public std::enable_shared_from_this<MessageParser>
 {
 private:
  MessageParser();
+
+  // declared before the signals, their slots use it until they are destroyed
+  class Private;
+  std::unique_ptr<Private> prv;
+
+  template<typename Signature>
+  friend class ParserSignal;
+
 public:
   [[nodiscard]] static std::shared_ptr<MessageParser> create();
 
+  /**
+   * @brief Emitted after the interest mask changed (see @ref getInterestMask), in the thread that connected or
+   * disconnected the slot. Declared before the signals below, their slots report the disconnect when destroyed.
+   * signature: void(GstMessageType interestMask)
+   */
+  bs2::signal<void(GstMessageType)> interestMaskChangedSignal;
+
   using AsyncHandler = std::function<void(std::function<void()>)>;
  /**
   * @brief Sets a custom asynchronous handler for parse().
   * @param handler A function that takes a callable and posts it to the desired main loop.
+  * The handler must call each posted task exactly once, the parser stays alive until its pending tasks have run.
   *
   * Example boost.asio:
   * @code
@@ -73,17 +222,65 @@ public:
   */
   [[nodiscard]] static std::shared_ptr<MessageParser> create(AsyncHandler handler);
 
+  /**
+   * @brief Statistics of the asynchronous parsing. The latencies are measured from parse() until the signals are emitted.
+   */
+  struct AsyncStats
+  {
+    std::uint64_t messages{0};          ///< messages handled asynchronously
+    std::uint64_t batches{0};           ///< tasks run by the async handler
+    GstClockTime lastQueueLatency{0};
+    GstClockTime maxQueueLatency{0};
+    GstClockTime totalQueueLatency{0};  ///< divide by messages for the average
+  };
+
   ~MessageParser();
 
   /**
    * @brief Parses a GStreamer message and emits corresponding signals based on its type.
    * If no async handler is set, the message is processed synchronously.
+   * Messages of types without connected slots are ignored (see @ref getInterestMask).
    * @param message The GStreamer message to parse.
    */
   void parse(const GstMessage& message);
 
+  /**
+   * @brief Limit the number of messages handled by one task of the async handler.
+   * Messages arriving while a task is pending are added to it instead of posting a new task.
+   * Default 0: the task handles all messages pending when it runs.
+   * Use a small limit to give other work of the main loop a chance between the messages.
+   * @param maxBatchSize maximum number of messages per task or 0 for unlimited
+   */
+  void setMaxBatchSize(std::size_t maxBatchSize);
+
+  /**
+   * @brief Count all parsed messages and measure the duration of each connected slot.
+   * A slot is reported under its name, see @ref ParserSignal::connectNamed. Set it before messages are parsed.
+   * @param metrics the metrics or nullptr to disable
+   */
+  void setMetrics(std::shared_ptr<BusMetrics> metrics);
+
+  [[nodiscard]] AsyncStats getAsyncStats() const;
+  void resetAsyncStats();
+
+  /**
+   * @brief Get the mask of the message types with at least one connected slot.
+   * Use it to filter the bus before messages reach the parser, e.g. with gst_bus_timed_pop_filtered.
+   * The mask changes whenever slots are connected or disconnected. It is cached, reading it is cheap.
+   * @return the message types the parser would emit a signal for
+   */
+  [[nodiscard]] GstMessageType getInterestMask() const;
+
 private:
   void parseSync(const GstMessage& message);
+  void emitSignals(const GstMessage& message);
+  void postDrainTask();
+  void drainPending();
+  bool isObserved(GstMessageType type) const;
+  void addObservedSlot(GstMessageType type);
+  void removeObservedSlot(GstMessageType type);
+  bool hasMetrics() const;
+  void recordSlotDuration(const std::string& slotName, GstMessageType type, GstClockTime duration);
 
 public:
 
@@ -91,7 +288,7 @@ public:
    * @brief Signal emitted when an End-Of-Stream (EOS) message is received.
    * @param sourceName The name of the element that generated the message.
    */
-  bs2::signal<void(const std::string& sourceName)> endOfStreamSignal;
+  ParserSignal<void(const std::string& sourceName)> endOfStreamSignal{*this, GST_MESSAGE_EOS, "endOfStreamSignal"};
 
   /**
    * @brief Signal emitted when an error message is received.
@@ -99,7 +296,7 @@ public:
    * @param errorMessage The error message.
    * @param debugInfo Additional debug information.
    */
-  bs2::signal<void(const std::string& sourceName, const std::string& errorMessage, const std::string& debugInfo)> errorSignal;
+  ParserSignal<void(const std::string& sourceName, const std::string& errorMessage, const std::string& debugInfo)> errorSignal{*this, GST_MESSAGE_ERROR, "errorSignal"};
 
   /**
    * @brief Signal emitted when a state change message is received.
@@ -108,7 +305,7 @@ public:
    * @param newState The new state.
    * @param pendingState The pending state.
    */
-  bs2::signal<void(const std::string& sourceName, GstState oldState, GstState newState, GstState pendingState)> stateChangedSignal;
+  ParserSignal<void(const std::string& sourceName, GstState oldState, GstState newState, GstState pendingState)> stateChangedSignal{*this, GST_MESSAGE_STATE_CHANGED, "stateChangedSignal"};
 
   /**
    * @brief Signal emitted when a warning message is received.
@@ -116,13 +313,13 @@ public:
    * @param warningMessage The warning message.
    * @param debugInfo Additional debug information.
    */
-  bs2::signal<void(const std::string& sourceName, const std::string& warningMessage, const std::string& debugInfo)> warningSignal;
+  ParserSignal<void(const std::string& sourceName, const std::string& warningMessage, const std::string& debugInfo)> warningSignal{*this, GST_MESSAGE_WARNING, "warningSignal"};
 
   /**
    * @brief Signal emitted when a duration change message is received.
    * @param sourceName The name of the element that generated the message.
    */
-  bs2::signal<void(const std::string& sourceName)> durationChangedSignal;
+  ParserSignal<void(const std::string& sourceName)> durationChangedSignal{*this, GST_MESSAGE_DURATION_CHANGED, "durationChangedSignal"};
 
   /**
    * @brief Signal emitted when an info message is received.
@@ -130,7 +327,7 @@ public:
    * @param infoMessage The info message.
    * @param debugInfo Additional debug information.
    */
-  bs2::signal<void(const std::string& sourceName, const std::string& infoMessage, const std::string& debugInfo)> infoSignal;
+  ParserSignal<void(const std::string& sourceName, const std::string& infoMessage, const std::string& debugInfo)> infoSignal{*this, GST_MESSAGE_INFO, "infoSignal"};
 
   /**
    * @brief Signal emitted when a stream status message is received.
@@ -138,33 +335,110 @@ public:
    * @param statusType The stream status type.
    * @param ownerName The owner element of the message source.
    */
-  bs2::signal<void(const std::string& sourceName, GstStreamStatusType statusType, const std::string& ownerName)> streamStatusSignal;
+  ParserSignal<void(const std::string& sourceName, GstStreamStatusType statusType, const std::string& ownerName)> streamStatusSignal{*this, GST_MESSAGE_STREAM_STATUS, "streamStatusSignal"};
 
  /**
   * @brief Signal emitted when a stream has started
   * @param sourceName The name of the element that generated the message.
   */
-  bs2::signal<void(const std::string& sourceName)> streamStartSignal;
+  ParserSignal<void(const std::string& sourceName)> streamStartSignal{*this, GST_MESSAGE_STREAM_START, "streamStartSignal"};
 
   /**
    * @brief an element specific message was received.
    */
-  bs2::signal<void(const std::string& sourceName, const GstStructure* structure)> elementMessageSignal;
+  ParserSignal<void(const std::string& sourceName, const GstStructure* structure)> elementMessageSignal{*this, GST_MESSAGE_ELEMENT, "elementMessageSignal"};
 
   /**
    * @brief Signal emitted when an ASYNC_DONE message is received.
    * @param sourceName The name of the element that generated the message.
    * @param runningTime The running time associated with the async done message (in nanoseconds).
    */
-  bs2::signal<void(const std::string& sourceName, GstClockTime runningTime)> asyncDoneSignal;
+  ParserSignal<void(const std::string& sourceName, GstClockTime runningTime)> asyncDoneSignal{*this, GST_MESSAGE_ASYNC_DONE, "asyncDoneSignal"};
+
+  /**
+   * @name Record signals
+   * Emitted together with the signals above, but with typed records referencing the message instead of strings.
+   * Parsing a message for these signals does not allocate memory.
+   * The std::string signals above only build their strings if a slot is connected.
+   */
+  ///@{
+  ParserSignal<void(const MessageRecord& record)> endOfStreamRecordSignal{*this, GST_MESSAGE_EOS, "endOfStreamRecordSignal"};
+  ParserSignal<void(const TextMessageRecord& record)> errorRecordSignal{*this, GST_MESSAGE_ERROR, "errorRecordSignal"};
+  ParserSignal<void(const TextMessageRecord& record)> warningRecordSignal{*this, GST_MESSAGE_WARNING, "warningRecordSignal"};
+  ParserSignal<void(const TextMessageRecord& record)> infoRecordSignal{*this, GST_MESSAGE_INFO, "infoRecordSignal"};
+  ParserSignal<void(const StateChangedRecord& record)> stateChangedRecordSignal{*this, GST_MESSAGE_STATE_CHANGED, "stateChangedRecordSignal"};
+  ParserSignal<void(const MessageRecord& record)> durationChangedRecordSignal{*this, GST_MESSAGE_DURATION_CHANGED, "durationChangedRecordSignal"};
+  ParserSignal<void(const StreamStatusRecord& record)> streamStatusRecordSignal{*this, GST_MESSAGE_STREAM_STATUS, "streamStatusRecordSignal"};
+  ParserSignal<void(const MessageRecord& record)> streamStartRecordSignal{*this, GST_MESSAGE_STREAM_START, "streamStartRecordSignal"};
+  ParserSignal<void(const ElementMessageRecord& record)> elementMessageRecordSignal{*this, GST_MESSAGE_ELEMENT, "elementMessageRecordSignal"};
+  ParserSignal<void(const AsyncDoneRecord& record)> asyncDoneRecordSignal{*this, GST_MESSAGE_ASYNC_DONE, "asyncDoneRecordSignal"};
+  ParserSignal<void(const QosRecord& record)> qosRecordSignal{*this, GST_MESSAGE_QOS, "qosRecordSignal"};
+  /// see @ref Pipeline::enableLatencyRecalculation
+  ParserSignal<void(const MessageRecord& record)> latencyRecordSignal{*this, GST_MESSAGE_LATENCY, "latencyRecordSignal"};
+  ParserSignal<void(const BufferingRecord& record)> bufferingRecordSignal{*this, GST_MESSAGE_BUFFERING, "bufferingRecordSignal"};
+  ParserSignal<void(const ProgressRecord& record)> progressRecordSignal{*this, GST_MESSAGE_PROGRESS, "progressRecordSignal"};
+  ///@}
 
 
 private:
-  std::string getSourceName(const GstMessage& message) const;
-  class Private;
-  std::unique_ptr<Private> prv;
+  static std::string_view getSourceName(const GstMessage& message);
 };
 
+template<typename... Args>
+ParserSignal<void(Args...)>::ParserSignal(MessageParser& parser, GstMessageType messageType, std::string name)
+: parser{parser}
+, messageType{messageType}
+, name{std::move(name)}
+{
+}
+
+template<typename... Args>
+bs2::connection ParserSignal<void(Args...)>::connect(const slot_type& slot, bs2::connect_position position)
+{
+  return Base::connect(wrap(slot, name + "#" + std::to_string(++connectionCount)), position);
+}
+
+template<typename... Args>
+bs2::connection ParserSignal<void(Args...)>::connect(const group_type& group, const slot_type& slot, bs2::connect_position position)
+{
+  return Base::connect(group, wrap(slot, name + "#" + std::to_string(++connectionCount)), position);
+}
+
+template<typename... Args>
+bs2::connection ParserSignal<void(Args...)>::connectNamed(std::string slotName, const slot_type& slot, bs2::connect_position position)
+{
+  return Base::connect(wrap(slot, std::move(slotName)), position);
+}
+
+template<typename... Args>
+typename ParserSignal<void(Args...)>::slot_type ParserSignal<void(Args...)>::wrap(const slot_type& slot, std::string slotName)
+{
+  // boost::signals2 releases the slot when it is disconnected, the guard in the wrapper reports that to the parser
+  parser.addObservedSlot(messageType);
+  std::shared_ptr<void> guard(
+    nullptr,
+    [&parser = parser, type = messageType](void*)
+    {
+      parser.removeObservedSlot(type);
+    }
+  );
+  slot_type wrapped(
+    [&parser = parser, type = messageType, slot, slotName = std::move(slotName), guard = std::move(guard)](Args... args)
+    {
+      if(! parser.hasMetrics())
+      {
+        slot(args...);
+        return;
+      }
+      const GstClockTime start = gst_util_get_timestamp();
+      slot(args...);
+      parser.recordSlotDuration(slotName, type, gst_util_get_timestamp() - start);
+    }
+  );
+  wrapped.track(slot);
+  return wrapped;
+}
+
 } // dh::gst
 
 #endif //DH_GST_MESSAGEPARSER_HPP
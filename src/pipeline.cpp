@@ -22,11 +22,198 @@
 #include "pipeline.hpp"
 
 // std
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <stdexcept>
 
 namespace dh::gst
 {
 
+namespace
+{
+template<typename QueryFunction>
+std::optional<LatencyInfo> queryLatencyOf(QueryFunction queryFunction)
+{
+  const auto query = makeGstSharedPtr(gst_query_new_latency(), TransferType::Full);
+  if(! queryFunction(query.get()))
+  {
+    return std::nullopt;
+  }
+  gboolean live = FALSE;
+  LatencyInfo info;
+  gst_query_parse_latency(query.get(), &live, &info.min, &info.max);
+  info.live = live;
+  return info;
+}
+
+/**
+ * @brief waits for a message on the bus of a pipeline, seen from the posting thread by a sync-message handler
+ */
+class MessageWaiter
+{
+public:
+  MessageWaiter(GstPipeline* pipeline, GstMessageType types)
+  : bus{makeGstSharedPtr(gst_pipeline_get_bus(pipeline), TransferType::Full)}
+  , state{std::make_shared<State>()}
+  {
+    state->pipeline = GST_OBJECT_CAST(pipeline);
+    state->types = types;
+    gst_bus_enable_sync_message_emission(bus.get());
+    handlerId = g_signal_connect_data(
+      bus.get(),
+      "sync-message",
+      G_CALLBACK(&MessageWaiter::onSyncMessage),
+      new std::shared_ptr<State>(state),
+      [](gpointer data, GClosure*){ delete static_cast<std::shared_ptr<State>*>(data); },
+      static_cast<GConnectFlags>(0)
+    );
+  }
+
+  MessageWaiter(const MessageWaiter&) = delete;
+  MessageWaiter& operator=(const MessageWaiter&) = delete;
+
+  ~MessageWaiter()
+  {
+    g_signal_handler_disconnect(bus.get(), handlerId);
+    gst_bus_disable_sync_message_emission(bus.get());
+  }
+
+  /**
+   * @param timeout the maximum time to wait, GST_CLOCK_TIME_NONE to wait until a message is received
+   * @return the type of the received message (or ERROR) or GST_MESSAGE_UNKNOWN on timeout
+   */
+  GstMessageType wait(GstClockTime timeout)
+  {
+    std::unique_lock lock(state->mutex);
+    const auto isReceived = [this]{ return state->received != GST_MESSAGE_UNKNOWN; };
+    if(GST_CLOCK_TIME_IS_VALID(timeout))
+    {
+      state->condition.wait_for(lock, std::chrono::nanoseconds(timeout), isReceived);
+    }
+    else
+    {
+      // GST_CLOCK_TIME_NONE would wrap to a negative duration
+      state->condition.wait(lock, isReceived);
+    }
+    return state->received;
+  }
+
+private:
+  struct State
+  {
+    std::mutex mutex;
+    std::condition_variable condition;
+    GstObject* pipeline{nullptr}; // kept alive by the caller
+    GstMessageType types{GST_MESSAGE_UNKNOWN};
+    GstMessageType received{GST_MESSAGE_UNKNOWN};
+  };
+
+  static void onSyncMessage(GstBus* /*bus*/, GstMessage* message, gpointer data)
+  {
+    auto& state = **static_cast<std::shared_ptr<State>*>(data);
+    const GstMessageType type = GST_MESSAGE_TYPE(message);
+    GstObject* source = GST_MESSAGE_SRC(message);
+    if(type == GST_MESSAGE_ERROR)
+    {
+      if(! source || (source != state.pipeline && ! gst_object_has_as_ancestor(source, state.pipeline)))
+      {
+        return;
+      }
+    }
+    else if(! (type & state.types) || (type == GST_MESSAGE_ASYNC_DONE && source != state.pipeline))
+    {
+      return;
+    }
+
+    std::lock_guard lock(state.mutex);
+    if(state.received == GST_MESSAGE_UNKNOWN)
+    {
+      state.received = type;
+      state.condition.notify_all();
+    }
+  }
+
+  GstBusSPtr bus;
+  std::shared_ptr<State> state;
+  gulong handlerId{0};
+};
+
+/**
+ * @brief send the event to the pipeline and wait for the completion message
+ * @param completion the message type that completes the event, GST_MESSAGE_UNKNOWN if sending completes it
+ */
+SeekResult sendTimed(GstPipeline* pipeline, GstEvent* event, GstMessageType completion, GstClockTime timeout)
+{
+  std::unique_ptr<MessageWaiter> waiter;
+  if(completion != GST_MESSAGE_UNKNOWN)
+  {
+    // connect before sending, so no message is missed
+    waiter = std::make_unique<MessageWaiter>(pipeline, completion);
+  }
+
+  SeekResult result;
+  const gchar* eventName = GST_EVENT_TYPE_NAME(event); // static string, the event is gone after sending
+  const GstClockTime started = gst_util_get_timestamp();
+  // gst_element_send_event: transfer full of the event
+  if(! gst_element_send_event(GST_ELEMENT_CAST(pipeline), event))
+  {
+    GST_WARNING_OBJECT(pipeline, "%s event was not handled", eventName);
+    return result;
+  }
+  result.success = ! waiter || waiter->wait(timeout) == completion;
+  result.duration = GST_CLOCK_DIFF(started, gst_util_get_timestamp());
+  return result;
+}
+
+GstSeekFlags makeSeekFlags(const SeekOptions& options)
+{
+  guint flags = GST_SEEK_FLAG_NONE;
+  if(options.flush)
+  {
+    flags |= GST_SEEK_FLAG_FLUSH;
+  }
+  if(options.segment)
+  {
+    flags |= GST_SEEK_FLAG_SEGMENT;
+  }
+  switch(options.accuracy)
+  {
+    case SeekAccuracy::Accurate:
+      flags |= GST_SEEK_FLAG_ACCURATE;
+      break;
+    case SeekAccuracy::KeyUnit:
+      flags |= GST_SEEK_FLAG_KEY_UNIT;
+      break;
+    case SeekAccuracy::SnapBefore:
+      flags |= GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_BEFORE;
+      break;
+    case SeekAccuracy::SnapAfter:
+      flags |= GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_AFTER;
+      break;
+    case SeekAccuracy::SnapNearest:
+      flags |= GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST;
+      break;
+  }
+  switch(options.trickMode)
+  {
+    case TrickMode::None:
+      break;
+    case TrickMode::All:
+      flags |= GST_SEEK_FLAG_TRICKMODE;
+      break;
+    case TrickMode::KeyUnits:
+      flags |= GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS;
+      break;
+    case TrickMode::KeyUnitsNoAudio:
+      flags |= GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS | GST_SEEK_FLAG_TRICKMODE_NO_AUDIO;
+      break;
+  }
+  return static_cast<GstSeekFlags>(flags);
+}
+} // namespace
+
 Pipeline::Pipeline(GstPipelineSPtr gstPipeline)
 : Bin(GST_BIN_CAST(gstPipeline.get()), TransferType::None) // no pointer_cast because C inheritance
 {
@@ -120,6 +307,152 @@ std::shared_ptr<Bus> Pipeline::getBus() const
   return Bus::create(gst_pipeline_get_bus(const_cast<GstPipeline*>(getRawGstPipeline())), TransferType::Full);
 }
 
+bs2::connection Pipeline::enableLatencyRecalculation(MessageParser& parser)
+{
+  return parser.latencyRecordSignal.connectNamed(
+    "Pipeline::enableLatencyRecalculation",
+    [self = std::static_pointer_cast<Pipeline>(shared_from_this())](const MessageRecord& record)
+    {
+      GstObject* source = GST_MESSAGE_SRC(&record.message);
+      GstObject* pipelineObject = self->getRawGstObject();
+      // the parser can be shared by several pipelines
+      if(! source || (source != pipelineObject && ! gst_object_has_as_ancestor(source, pipelineObject)))
+      {
+        return;
+      }
+      GST_DEBUG_OBJECT(pipelineObject, "latency message from '%s', recalculating latency", record.sourceName.data());
+      if(! self->recalculateLatency())
+      {
+        GST_WARNING_OBJECT(pipelineObject, "failed to recalculate latency");
+      }
+    }
+  );
+}
+
+std::optional<LatencyInfo> Pipeline::queryLatency() const
+{
+  return queryLatencyOf(
+    [this](GstQuery* query)
+    {
+      return gst_element_query(GST_ELEMENT_CAST(const_cast<GstPipeline*>(getRawGstPipeline())), query);
+    }
+  );
+}
+
+std::vector<ElementLatency> Pipeline::getLatencyBreakdown() const
+{
+  std::vector<ElementLatency> breakdown;
+  ElementRange elements(gst_bin_iterate_recurse(GST_BIN_CAST(const_cast<GstPipeline*>(getRawGstPipeline()))));
+  unsigned resyncCount = 0;
+  for(const auto& element : elements)
+  {
+    if(elements.getResyncCount() != resyncCount)
+    {
+      // the iteration started again
+      resyncCount = elements.getResyncCount();
+      breakdown.clear();
+    }
+    if(GST_IS_BIN(element.get()))
+    {
+      continue;
+    }
+    const auto output = queryLatencyOf(
+      [&element](GstQuery* query)
+      {
+        return gst_element_query(element.get(), query);
+      }
+    );
+    if(! output)
+    {
+      continue;
+    }
+
+    GstClockTime inputMin = 0;
+    for(const auto& sinkPad : PadRange(gst_element_iterate_sink_pads(element.get())))
+    {
+      // gst_pad_get_peer: transfer full
+      const auto peer = makeGstSharedPtr(gst_pad_get_peer(sinkPad.get()), TransferType::Full);
+      const auto input = peer
+        ? queryLatencyOf([&peer](GstQuery* query){ return gst_pad_query(peer.get(), query); })
+        : std::nullopt;
+      if(input)
+      {
+        inputMin = std::max(inputMin, input->min);
+      }
+    }
+    breakdown.push_back({
+      GST_OBJECT_NAME(element.get()),
+      *output,
+      output->min > inputMin ? output->min - inputMin : 0
+    });
+  }
+
+  std::stable_sort(
+    breakdown.begin(),
+    breakdown.end(),
+    [](const ElementLatency& a, const ElementLatency& b)
+    {
+      return a.ownLatency > b.ownLatency;
+    }
+  );
+  return breakdown;
+}
+
+void Pipeline::setLatency(GstClockTime latency)
+{
+  gst_pipeline_set_latency(getRawGstPipeline(), latency);
+}
+
+GstClockTime Pipeline::getLatency() const
+{
+  return gst_pipeline_get_latency(const_cast<GstPipeline*>(getRawGstPipeline()));
+}
+
+SeekResult Pipeline::seek(GstClockTime position, const SeekOptions& options)
+{
+  if(options.rate == 0.0)
+  {
+    throw std::invalid_argument("seek: rate must not be 0");
+  }
+  // reverse playback runs from stop back to start
+  const bool reverse = options.rate < 0.0;
+  const GstClockTime start = reverse ? (GST_CLOCK_TIME_IS_VALID(options.stop) ? options.stop : 0) : position;
+  const GstClockTime stop = reverse ? position : options.stop;
+
+  GstEvent* event = gst_event_new_seek(
+    options.rate,
+    GST_FORMAT_TIME,
+    makeSeekFlags(options),
+    GST_SEEK_TYPE_SET, start,
+    GST_CLOCK_TIME_IS_VALID(stop) ? GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_IS_VALID(stop) ? stop : 0
+  );
+  return sendTimed(getRawGstPipeline(), event, options.flush ? GST_MESSAGE_ASYNC_DONE : GST_MESSAGE_UNKNOWN, options.timeout);
+}
+
+#if DH_GST_HAS_INSTANT_RATE_CHANGE
+SeekResult Pipeline::setRate(double rate)
+{
+  if(rate == 0.0)
+  {
+    throw std::invalid_argument("setRate: rate must not be 0");
+  }
+  GstEvent* event = gst_event_new_seek(
+    rate,
+    GST_FORMAT_TIME,
+    GST_SEEK_FLAG_INSTANT_RATE_CHANGE,
+    GST_SEEK_TYPE_NONE, 0,
+    GST_SEEK_TYPE_NONE, 0
+  );
+  return sendTimed(getRawGstPipeline(), event, GST_MESSAGE_UNKNOWN, 0);
+}
+#endif
+
+SeekResult Pipeline::step(guint64 amount, GstFormat format, GstClockTime timeout)
+{
+  GstEvent* event = gst_event_new_step(format, amount, 1.0, TRUE, FALSE);
+  return sendTimed(getRawGstPipeline(), event, GST_MESSAGE_STEP_DONE, timeout);
+}
+
 GstPipeline* Pipeline::getRawGstPipeline()
 {
   return GST_PIPELINE_CAST(getRawGstObject());
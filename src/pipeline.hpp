@@ -24,16 +24,86 @@
 // local includes
 #include "bin.hpp"
 #include "bus.hpp"
+#include "messageparser.hpp"
 #include "sharedptrs.hpp"
 
+// std
+#include <optional>
+#include <string>
+#include <vector>
+
 // gstreamer
 #include <gst/gst.h>
 
 #define DH_GST_HAS_PIPELINE_IS_LIVE GST_CHECK_VERSION(1, 24, 0)
+#define DH_GST_HAS_INSTANT_RATE_CHANGE GST_CHECK_VERSION(1, 18, 0)
 
 namespace dh::gst
 {
 
+/**
+ * @brief result of a latency query, see gst_query_parse_latency
+ */
+struct LatencyInfo
+{
+  bool live{false};
+  GstClockTime min{0};
+  GstClockTime max{GST_CLOCK_TIME_NONE}; ///< GST_CLOCK_TIME_NONE if unlimited
+};
+
+/**
+ * @brief latency of a single element of a pipeline, see @ref Pipeline::getLatencyBreakdown
+ */
+struct ElementLatency
+{
+  std::string elementName;
+  LatencyInfo latency;     ///< accumulated latency at the output of the element, including everything upstream
+  GstClockTime ownLatency; ///< min latency added by this element: latency.min minus the largest min latency at its inputs
+};
+
+/**
+ * @brief where a seek ends up, see @ref SeekOptions
+ */
+enum class SeekAccuracy
+{
+  Accurate,   ///< exactly at the position, decodes from the previous key unit (slow)
+  KeyUnit,    ///< at the nearest key unit, the position is adjusted by the demuxer
+  SnapBefore, ///< at the key unit before the position
+  SnapAfter,  ///< at the key unit after the position
+  SnapNearest ///< at the key unit closest to the position
+};
+
+/**
+ * @brief which frames are decoded during fast forward/rewind, see @ref SeekOptions
+ */
+enum class TrickMode
+{
+  None,
+  All,             ///< GST_SEEK_FLAG_TRICKMODE, elements may skip frames
+  KeyUnits,        ///< only key units are decoded
+  KeyUnitsNoAudio  ///< only key units are decoded and audio is not decoded at all
+};
+
+struct SeekOptions
+{
+  SeekAccuracy accuracy{SeekAccuracy::KeyUnit};
+  double rate{1.0};                      ///< playback rate, negative for reverse playback
+  TrickMode trickMode{TrickMode::None};
+  bool flush{true};                      ///< discard queued data, the seek completes with ASYNC_DONE
+  bool segment{false};                   ///< post SEGMENT_DONE instead of EOS at the end, for gapless loops
+  GstClockTime stop{GST_CLOCK_TIME_NONE}; ///< where playback ends; for reverse playback the earlier end (0 if NONE)
+  GstClockTime timeout{5 * GST_SECOND};  ///< maximum time to wait for the completion, GST_CLOCK_TIME_NONE for no limit
+};
+
+/**
+ * @brief result of a seek, rate change or step
+ */
+struct SeekResult
+{
+  bool success{false};                      ///< handled and completed within the timeout
+  GstClockTime duration{GST_CLOCK_TIME_NONE}; ///< time from sending the event until the completion
+};
+
 class Pipeline final : public Bin
 {
 protected:
@@ -102,6 +172,75 @@ public:
 
   [[nodiscard]] std::shared_ptr<Bus> getBus() const;
 
+  /**
+   * @brief Recalculate the latency of the pipeline whenever the parser gets a LATENCY message of one of its elements.
+   * Without, the pipeline keeps the latency calculated when going to PLAYING,
+   * even if elements change their latency later, and live sinks drop late buffers.
+   * The parser must not be called from a streaming thread (e.g. a bus sync handler), use an async handler or a bus watch.
+   * The connection keeps a reference to the Pipeline until it is disconnected.
+   * @param parser the parser the bus messages of the pipeline are passed to
+   * @return the connection to the latency signal of the parser
+   */
+  bs2::connection enableLatencyRecalculation(MessageParser& parser);
+
+  /**
+   * @brief Query the latency of the whole pipeline (GST_QUERY_LATENCY).
+   * @return the latency or std::nullopt if the query failed, e.g. because the pipeline is not PAUSED or PLAYING
+   */
+  [[nodiscard]] std::optional<LatencyInfo> queryLatency() const;
+
+  /**
+   * @brief Query the latency of every element (recursing into bins) to find the largest contributors.
+   * Each element is queried at its output and at the peers of its sink pads, the difference is its own latency.
+   * Elements that don't answer are left out. Bins are left out, their children are listed.
+   * @return the elements, largest ownLatency first
+   */
+  [[nodiscard]] std::vector<ElementLatency> getLatencyBreakdown() const;
+
+  /**
+   * @brief Set a fixed latency instead of the one from the latency query (gst_pipeline_set_latency).
+   * @param latency the latency, GST_CLOCK_TIME_NONE to use the queried latency again
+   */
+  void setLatency(GstClockTime latency);
+
+  /**
+   * @brief Get the latency set with @ref setLatency.
+   * @return the latency or GST_CLOCK_TIME_NONE if the queried latency is used
+   */
+  [[nodiscard]] GstClockTime getLatency() const;
+
+  /**
+   * @brief Seek to a position (GST_FORMAT_TIME) and wait until the seek is completed.
+   * A flushing seek is completed by the ASYNC_DONE of the pipeline (the new position is prerolled),
+   * a non flushing seek when the event was handled.
+   * The completion is seen on the bus with sync-message handlers, other consumers of the bus are not affected.
+   * @param position the target position
+   * @param options accuracy, rate, trick mode, ...
+   * @return the result with the time the seek took
+   * @throws std::invalid_argument if the rate is 0
+   */
+  SeekResult seek(GstClockTime position, const SeekOptions& options = {});
+
+#if DH_GST_HAS_INSTANT_RATE_CHANGE
+  /**
+   * @brief Change the playback rate without flushing (GST_SEEK_FLAG_INSTANT_RATE_CHANGE).
+   * The direction can not be changed this way, use @ref seek for that.
+   * @param rate the new rate
+   * @return the result, complete when the event was handled
+   * @throws std::invalid_argument if rate is 0
+   */
+  SeekResult setRate(double rate);
+#endif
+
+  /**
+   * @brief Step a number of frames (or another amount) in PAUSED and wait for STEP_DONE.
+   * @param amount the amount to step
+   * @param format GST_FORMAT_BUFFERS for frames, GST_FORMAT_TIME for a duration
+   * @param timeout maximum time to wait for STEP_DONE, GST_CLOCK_TIME_NONE for no limit
+   * @return the result with the time the step took
+   */
+  SeekResult step(guint64 amount = 1, GstFormat format = GST_FORMAT_BUFFERS, GstClockTime timeout = 5 * GST_SECOND);
+
 private:
   [[nodiscard]] GstPipeline* getRawGstPipeline();
   [[nodiscard]] const GstPipeline* getRawGstPipeline() const;
@@ -0,0 +1,274 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "pipelinepool.hpp"
+
+// std
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace dh::gst
+{
+
+namespace
+{
+// after a failure, don't try again in a busy loop
+constexpr auto retryDelay = std::chrono::seconds(1);
+} // namespace
+
+class PipelinePool::Private
+{
+public:
+  Factory factory;
+  std::size_t size{0};
+  GstState parkState{GST_STATE_PAUSED};
+  std::atomic<GstClockTime> prewarmTimeout{5 * GST_SECOND};
+
+  mutable std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::shared_ptr<Pipeline>> available;
+  std::deque<std::shared_ptr<Pipeline>> recycled;
+  bool running{true};
+  std::thread thread;
+
+  std::atomic<std::size_t> misses{0};
+  std::atomic<std::size_t> failures{0};
+
+  /**
+   * @brief bring the pipeline to the park state
+   * @return false if the state is not reached within the timeout
+   */
+  bool park(Pipeline& pipeline)
+  {
+    if(pipeline.setState(parkState) != GST_STATE_CHANGE_FAILURE)
+    {
+      const auto result = pipeline.getState(prewarmTimeout).result;
+      if(result == GST_STATE_CHANGE_SUCCESS || result == GST_STATE_CHANGE_NO_PREROLL)
+      {
+        return true;
+      }
+    }
+    GST_WARNING("PipelinePool: pipeline '%s' did not reach %s", pipeline.getName().c_str(), gst_element_state_get_name(parkState));
+    pipeline.setState(GST_STATE_NULL);
+    ++failures;
+    return false;
+  }
+
+  std::shared_ptr<Pipeline> build()
+  {
+    std::shared_ptr<Pipeline> pipeline;
+    try
+    {
+      pipeline = factory();
+    }
+    catch(const std::exception& e)
+    {
+      GST_WARNING("PipelinePool: factory threw: %s", e.what());
+    }
+    if(! pipeline)
+    {
+      ++failures;
+      return nullptr;
+    }
+    return park(*pipeline) ? pipeline : nullptr;
+  }
+
+  void run()
+  {
+    std::unique_lock lock(mutex);
+    while(running)
+    {
+      std::shared_ptr<Pipeline> pipeline;
+      bool built = false;
+      if(! recycled.empty())
+      {
+        pipeline = std::move(recycled.front());
+        recycled.pop_front();
+        lock.unlock();
+        pipeline->setState(GST_STATE_READY);
+        // unlike NULL, READY does not flush the bus, a stale EOS or ERROR would reach the next user
+        auto bus = pipeline->getBus()->getGstBus();
+        gst_bus_set_flushing(bus.get(), TRUE);
+        gst_bus_set_flushing(bus.get(), FALSE);
+        if(! park(*pipeline))
+        {
+          pipeline.reset();
+        }
+      }
+      else if(available.size() < size)
+      {
+        lock.unlock();
+        pipeline = build();
+        built = true;
+      }
+      else
+      {
+        condition.wait(lock);
+        continue;
+      }
+
+      lock.lock();
+      if(pipeline && running && available.size() < size)
+      {
+        available.push_back(std::move(pipeline));
+        condition.notify_all();
+      }
+      else if(pipeline)
+      {
+        lock.unlock();
+        pipeline->setState(GST_STATE_NULL);
+        pipeline.reset();
+        lock.lock();
+      }
+      else if(built)
+      {
+        condition.wait_for(lock, retryDelay, [this]{ return ! running || ! recycled.empty(); });
+      }
+    }
+  }
+};
+
+PipelinePool::PipelinePool(Factory factory, std::size_t size, GstState parkState)
+: prv{std::make_shared<Private>()}
+{
+  if(! factory)
+  {
+    throw std::invalid_argument("PipelinePool: no factory given");
+  }
+  if(parkState != GST_STATE_READY && parkState != GST_STATE_PAUSED)
+  {
+    throw std::invalid_argument("PipelinePool: park state must be READY or PAUSED");
+  }
+  prv->factory = std::move(factory);
+  prv->size = size;
+  prv->parkState = parkState;
+  prv->thread = std::thread([prv = prv]{ prv->run(); });
+}
+
+PipelinePool::~PipelinePool()
+{
+  {
+    std::lock_guard lock(prv->mutex);
+    prv->running = false;
+  }
+  prv->condition.notify_all();
+  prv->thread.join();
+
+  for(auto* pipelines : {&prv->available, &prv->recycled})
+  {
+    for(const auto& pipeline : *pipelines)
+    {
+      pipeline->setState(GST_STATE_NULL);
+    }
+    pipelines->clear();
+  }
+}
+
+std::shared_ptr<PipelinePool> PipelinePool::create(Factory factory, std::size_t size, GstState parkState)
+{
+  return std::shared_ptr<PipelinePool>(new PipelinePool(std::move(factory), size, parkState));
+}
+
+std::shared_ptr<Pipeline> PipelinePool::acquire()
+{
+  {
+    std::lock_guard lock(prv->mutex);
+    if(! prv->available.empty())
+    {
+      auto pipeline = std::move(prv->available.front());
+      prv->available.pop_front();
+      prv->condition.notify_all();
+      return pipeline;
+    }
+  }
+  ++prv->misses;
+  GST_DEBUG("PipelinePool: no prewarmed pipeline available, creating one");
+  return prv->factory();
+}
+
+void PipelinePool::recycle(std::shared_ptr<Pipeline> pipeline)
+{
+  if(! pipeline)
+  {
+    return;
+  }
+  {
+    std::lock_guard lock(prv->mutex);
+    if(prv->running && prv->available.size() + prv->recycled.size() < prv->size)
+    {
+      prv->recycled.push_back(std::move(pipeline));
+      prv->condition.notify_all();
+      return;
+    }
+  }
+  pipeline->setState(GST_STATE_NULL);
+}
+
+bool PipelinePool::waitUntilFull(GstClockTime timeout)
+{
+  std::unique_lock lock(prv->mutex);
+  const auto isFull = [this]{ return prv->available.size() >= prv->size; };
+  if(! GST_CLOCK_TIME_IS_VALID(timeout))
+  {
+    // GST_CLOCK_TIME_NONE would wrap to a negative duration
+    prv->condition.wait(lock, isFull);
+    return true;
+  }
+  return prv->condition.wait_for(lock, std::chrono::nanoseconds(timeout), isFull);
+}
+
+void PipelinePool::setPrewarmTimeout(GstClockTime timeout)
+{
+  prv->prewarmTimeout = timeout;
+}
+
+std::size_t PipelinePool::getSize() const
+{
+  return prv->size;
+}
+
+std::size_t PipelinePool::getAvailableCount() const
+{
+  std::lock_guard lock(prv->mutex);
+  return prv->available.size();
+}
+
+GstState PipelinePool::getParkState() const
+{
+  return prv->parkState;
+}
+
+std::size_t PipelinePool::getMissCount() const
+{
+  return prv->misses;
+}
+
+std::size_t PipelinePool::getFailureCount() const
+{
+  return prv->failures;
+}
+
+} // dh::gst
@@ -0,0 +1,125 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_PIPELINEPOOL_HPP
+#define DH_GST_PIPELINEPOOL_HPP
+
+// local includes
+#include "pipeline.hpp"
+
+// std
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+// C
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Keeps a number of pipelines built and parked in READY or PAUSED (prerolled),
+ * so an acquired pipeline only needs the switch to PLAYING.
+ * Element creation, plugin loading and negotiation are done by an own thread in the background,
+ * which refills the pool after each acquire.
+ * @code
+ * auto clipTemplate = PipelineTemplate::create("filesrc location=\"${file}\" ! decodebin ! autovideosink");
+ * auto pool = PipelinePool::create([clipTemplate]{ return clipTemplate->instantiate({{"file", "intro.mp4"}}); }, 2);
+ * auto pipeline = pool->acquire();
+ * pipeline->setState(GST_STATE_PLAYING);
+ * @endcode
+ */
+class PipelinePool
+{
+protected:
+  /**
+   * @brief Create the pool and start filling it.
+   * @param factory creates a new pipeline in NULL state, called from the pool thread
+   * @param size the number of pipelines to keep prewarmed
+   * @param parkState GST_STATE_READY or GST_STATE_PAUSED
+   * @throws std::invalid_argument if factory is empty or parkState is not READY or PAUSED
+   */
+  PipelinePool(std::function<std::shared_ptr<Pipeline>()> factory, std::size_t size, GstState parkState);
+
+public:
+  using Factory = std::function<std::shared_ptr<Pipeline>()>;
+
+  [[nodiscard]] static std::shared_ptr<PipelinePool> create(Factory factory, std::size_t size, GstState parkState = GST_STATE_PAUSED);
+
+  /**
+   * @brief Stops the pool thread and sets the pooled pipelines to NULL.
+   * Acquired pipelines belong to the caller, who has to set them to NULL.
+   */
+  ~PipelinePool();
+
+  /**
+   * @brief Take a pipeline out of the pool.
+   * If no prewarmed pipeline is available, a new one is created by the factory in the calling thread
+   * (in NULL state) and counted as a miss.
+   * @return the pipeline, in the park state if it was prewarmed
+   * @throws what the factory throws on a miss
+   */
+  [[nodiscard]] std::shared_ptr<Pipeline> acquire();
+
+  /**
+   * @brief Give a pipeline back to the pool after use.
+   * The pool thread sets it to READY (which resets the sources), drops the messages left on its bus
+   * (e.g. the EOS of the last use) and then brings it to the park state again.
+   * If the pool is already full, the pipeline is set to NULL and dropped.
+   * @param pipeline the pipeline, e.g. after EOS
+   */
+  void recycle(std::shared_ptr<Pipeline> pipeline);
+
+  /**
+   * @brief Wait until the pool holds its full number of prewarmed pipelines.
+   * @param timeout the maximum time to wait, GST_CLOCK_TIME_NONE to wait until the pool is full
+   * @return true if the pool is full
+   */
+  bool waitUntilFull(GstClockTime timeout);
+
+  /**
+   * @brief Set the maximum time for a pipeline to reach the park state. Pipelines that need longer are dropped.
+   * @param timeout the timeout, default 5 seconds
+   */
+  void setPrewarmTimeout(GstClockTime timeout);
+
+  [[nodiscard]] std::size_t getSize() const;
+  [[nodiscard]] std::size_t getAvailableCount() const;
+  [[nodiscard]] GstState getParkState() const;
+
+  /**
+   * @brief Get the number of acquire calls that found the pool empty.
+   */
+  [[nodiscard]] std::size_t getMissCount() const;
+
+  /**
+   * @brief Get the number of pipelines that could not be created or did not reach the park state.
+   */
+  [[nodiscard]] std::size_t getFailureCount() const;
+
+private:
+  class Private;
+  std::shared_ptr<Private> prv; // shared with the pool thread
+};
+
+} // dh::gst
+
+#endif //DH_GST_PIPELINEPOOL_HPP
@@ -0,0 +1,482 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "pipelinesupervisor.hpp"
+#include "pipelinetemplate.hpp"
+#include "helpers.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace dh::gst
+{
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+GstClockTime toClockTime(Clock::duration duration)
+{
+  return static_cast<GstClockTime>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+} // namespace
+
+class PipelineSupervisor::Private
+{
+public:
+  explicit Private(PipelineSupervisor& supervisor)
+  : supervisor{supervisor}
+  {
+  }
+
+  PipelineSupervisor& supervisor; // only used by the supervisor thread, which is joined or ends before the supervisor
+  Factory factory;
+
+  // configuration
+  GstClockTime initialBackoff{100 * GST_MSECOND};
+  GstClockTime maxBackoff{30 * GST_SECOND};
+  double multiplier{2.0};
+  double jitter{0.2};
+  GstClockTime stableTime{10 * GST_SECOND};
+  GstState targetState{GST_STATE_PLAYING};
+  bool restartOnEos{true};
+  GstClockTime startTimeout{10 * GST_SECOND};
+
+  mutable std::mutex mutex;
+  std::condition_variable condition;
+  bool running{false};
+  unsigned runToken{0}; // a thread stopped from a slot and replaced by start() ends without touching the new pipeline
+  std::thread thread;
+
+  std::shared_ptr<Pipeline> pipeline;
+  GstBusSPtr bus;          // of the pipeline, watched by a sync-message handler
+  gulong syncHandlerId{0};
+  unsigned generation{0}; // messages of torn down pipelines are ignored
+  bool failurePending{false};
+  std::string failureReason;
+  Clock::time_point failureTime;
+  Clock::time_point startTime;
+  bool recovering{false};
+  Stats stats;
+  std::mt19937 random{std::random_device{}()};
+
+  /**
+   * @brief userdata of the sync-message handler
+   */
+  struct Watch
+  {
+    std::weak_ptr<Private> prv;
+    unsigned generation;
+    GstMessageType types;
+  };
+
+  /**
+   * @brief sync-message handler, called from the posting thread. The message stays on the bus.
+   * Extended types (e.g. GST_MESSAGE_STREAMS_SELECTED of decodebin3) share the bits of ERROR and EOS, they never match.
+   */
+  static void onSyncMessage(GstBus* /*bus*/, GstMessage* message, gpointer data)
+  {
+    const auto& watch = *static_cast<Watch*>(data);
+    if(! helpers::isMessageTypeInMask(GST_MESSAGE_TYPE(message), watch.types))
+    {
+      return;
+    }
+    if(const auto prv = watch.prv.lock())
+    {
+      prv->onMessage(watch.generation, message);
+    }
+  }
+
+  void onMessage(unsigned messageGeneration, GstMessage* message)
+  {
+    std::string reason;
+    if(GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR)
+    {
+      GError* error = nullptr;
+      gst_message_parse_error(message, &error, nullptr);
+      reason = std::string("error from ") + (GST_MESSAGE_SRC_NAME(message) ? GST_MESSAGE_SRC_NAME(message) : "unknown")
+        + ": " + (error ? error->message : "unknown");
+      g_clear_error(&error);
+    }
+    else
+    {
+      reason = "end of stream";
+    }
+
+    std::lock_guard lock(mutex);
+    if(messageGeneration != generation || failurePending)
+    {
+      return;
+    }
+    failurePending = true;
+    failureReason = std::move(reason);
+    failureTime = Clock::now();
+    condition.notify_all();
+  }
+
+  /**
+   * @brief build the pipeline and bring it to the target state, called without lock
+   * @return false on failure, failureReason is set then
+   */
+  bool startPipeline()
+  {
+    std::shared_ptr<Pipeline> newPipeline;
+    try
+    {
+      newPipeline = factory();
+    }
+    catch(const std::exception& e)
+    {
+      std::lock_guard lock(mutex);
+      failureReason = std::string("factory threw: ") + e.what();
+      return false;
+    }
+    if(! newPipeline)
+    {
+      std::lock_guard lock(mutex);
+      failureReason = "factory returned no pipeline";
+      return false;
+    }
+
+    GstMessageType messageTypes;
+    GstState state;
+    GstClockTime timeout;
+    unsigned pipelineGeneration;
+    {
+      std::lock_guard lock(mutex);
+      messageTypes = restartOnEos ? static_cast<GstMessageType>(GST_MESSAGE_ERROR | GST_MESSAGE_EOS) : GST_MESSAGE_ERROR;
+      state = targetState;
+      timeout = startTimeout;
+      pipelineGeneration = ++generation;
+      failurePending = false;
+      pipeline = newPipeline;
+    }
+
+    // a sync-message handler does not pop the messages, they stay on the bus for the application
+    auto newBus = newPipeline->getBus()->getGstBus();
+    gst_bus_enable_sync_message_emission(newBus.get());
+    const gulong newSyncHandlerId = g_signal_connect_data(
+      newBus.get(),
+      "sync-message",
+      G_CALLBACK(&Private::onSyncMessage),
+      new Watch{supervisor.prv, pipelineGeneration, messageTypes},
+      [](gpointer data, GClosure*){ delete static_cast<Watch*>(data); },
+      static_cast<GConnectFlags>(0)
+    );
+    {
+      std::lock_guard lock(mutex);
+      bus = std::move(newBus);
+      syncHandlerId = newSyncHandlerId;
+    }
+
+    GstStateChangeReturn result = newPipeline->setState(state);
+    if(result != GST_STATE_CHANGE_FAILURE)
+    {
+      result = newPipeline->getState(timeout).result;
+    }
+    if(result == GST_STATE_CHANGE_FAILURE || result == GST_STATE_CHANGE_ASYNC)
+    {
+      std::lock_guard lock(mutex);
+      failureReason = std::string("pipeline did not reach ") + gst_element_state_get_name(state);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief take the pipeline and set it to NULL, called without lock
+   */
+  void teardown()
+  {
+    std::shared_ptr<Pipeline> oldPipeline;
+    GstBusSPtr oldBus;
+    gulong oldSyncHandlerId;
+    {
+      std::lock_guard lock(mutex);
+      ++generation;
+      oldPipeline = std::move(pipeline);
+      oldBus = std::move(bus);
+      oldSyncHandlerId = std::exchange(syncHandlerId, 0);
+      pipeline.reset();
+      bus.reset();
+    }
+    if(oldBus)
+    {
+      // a running handler keeps its closure (and the Watch) until it returns
+      g_signal_handler_disconnect(oldBus.get(), oldSyncHandlerId);
+      gst_bus_disable_sync_message_emission(oldBus.get());
+    }
+    if(oldPipeline)
+    {
+      oldPipeline->setState(GST_STATE_NULL);
+    }
+  }
+
+  /**
+   * @brief count the failure and compute the delay until the next attempt, called with lock
+   */
+  std::chrono::nanoseconds registerFailure(Clock::time_point now)
+  {
+    const bool wasStable = ! recovering && now - startTime >= std::chrono::nanoseconds(stableTime);
+    stats.consecutiveFailures = wasStable ? 1 : stats.consecutiveFailures + 1;
+    ++stats.failures;
+    stats.lastFailure = failureReason;
+    if(! recovering)
+    {
+      failureTime = now;
+      recovering = true;
+    }
+
+    double delay = static_cast<double>(initialBackoff) * std::pow(multiplier, stats.consecutiveFailures - 1);
+    delay = std::min(delay, static_cast<double>(maxBackoff));
+    if(jitter > 0.0)
+    {
+      delay *= std::uniform_real_distribution<double>(1.0 - jitter, 1.0 + jitter)(random);
+    }
+    return std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(delay));
+  }
+
+  /**
+   * @brief check if the thread with the token should go on, called with lock
+   */
+  bool isCurrent(unsigned token) const
+  {
+    return running && runToken == token;
+  }
+
+  void run(unsigned token)
+  {
+    std::unique_lock lock(mutex);
+    std::chrono::nanoseconds delay{0};
+    while(isCurrent(token))
+    {
+      if(delay.count() > 0 && condition.wait_for(lock, delay, [this, token]{ return ! isCurrent(token); }))
+      {
+        break;
+      }
+
+      lock.unlock();
+      const bool started = startPipeline();
+      const auto startedPipeline = getPipeline();
+      lock.lock();
+
+      if(started && ! failurePending)
+      {
+        startTime = Clock::now();
+        if(recovering)
+        {
+          const GstClockTime recoveryTime = toClockTime(startTime - failureTime);
+          ++stats.restarts;
+          stats.lastRecoveryTime = recoveryTime;
+          stats.maxRecoveryTime = std::max(stats.maxRecoveryTime, recoveryTime);
+          stats.totalDowntime += recoveryTime;
+          recovering = false;
+        }
+        lock.unlock();
+        supervisor.pipelineStartedSignal(startedPipeline);
+        lock.lock();
+
+        condition.wait(lock, [this, token]{ return ! isCurrent(token) || failurePending; });
+        if(! isCurrent(token))
+        {
+          break;
+        }
+      }
+
+      GST_WARNING("PipelineSupervisor: %s", failureReason.c_str());
+      delay = registerFailure(failurePending ? failureTime : Clock::now());
+      const std::string reason = failureReason;
+      lock.unlock();
+      teardown();
+      supervisor.failureSignal(reason);
+      lock.lock();
+    }
+    // after a restart from a slot, the pipeline belongs to the new thread
+    const bool replaced = runToken != token;
+    lock.unlock();
+    if(! replaced)
+    {
+      teardown();
+    }
+  }
+
+  std::shared_ptr<Pipeline> getPipeline() const
+  {
+    std::lock_guard lock(mutex);
+    return pipeline;
+  }
+};
+
+PipelineSupervisor::PipelineSupervisor(Factory factory)
+: prv{std::make_shared<Private>(*this)}
+{
+  if(! factory)
+  {
+    throw std::invalid_argument("PipelineSupervisor: no factory given");
+  }
+  prv->factory = std::move(factory);
+}
+
+PipelineSupervisor::~PipelineSupervisor()
+{
+  stop();
+  std::lock_guard lock(prv->mutex);
+  if(prv->thread.joinable())
+  {
+    // destroyed from a slot (not supported): better than joining the own thread
+    prv->thread.detach();
+  }
+}
+
+std::shared_ptr<PipelineSupervisor> PipelineSupervisor::create(Factory factory)
+{
+  return std::shared_ptr<PipelineSupervisor>(new PipelineSupervisor(std::move(factory)));
+}
+
+std::shared_ptr<PipelineSupervisor> PipelineSupervisor::create(const std::string& description)
+{
+  auto pipelineTemplate = PipelineTemplate::create(description);
+  return create([pipelineTemplate]{ return pipelineTemplate->instantiate(); });
+}
+
+void PipelineSupervisor::start()
+{
+  std::unique_lock lock(prv->mutex);
+  if(prv->running)
+  {
+    return;
+  }
+  if(prv->thread.joinable())
+  {
+    if(prv->thread.get_id() == std::this_thread::get_id())
+    {
+      // stopped from a slot before: the old thread ends after the slot, the new token tells it to leave the pipeline alone
+      prv->thread.detach();
+      lock.unlock();
+      prv->teardown();
+      lock.lock();
+    }
+    else
+    {
+      lock.unlock();
+      prv->thread.join();
+      lock.lock();
+    }
+    if(prv->running || prv->thread.joinable())
+    {
+      // started concurrently from another thread
+      return;
+    }
+  }
+  prv->running = true;
+  prv->recovering = false;
+  const unsigned token = ++prv->runToken;
+  prv->thread = std::thread([prv = prv, token]{ prv->run(token); });
+}
+
+void PipelineSupervisor::stop()
+{
+  std::thread thread;
+  {
+    std::lock_guard lock(prv->mutex);
+    prv->running = false;
+    prv->condition.notify_all();
+    if(! prv->thread.joinable() || prv->thread.get_id() == std::this_thread::get_id())
+    {
+      return;
+    }
+    thread = std::move(prv->thread);
+  }
+  thread.join();
+}
+
+bool PipelineSupervisor::isRunning() const
+{
+  std::lock_guard lock(prv->mutex);
+  return prv->running;
+}
+
+std::shared_ptr<Pipeline> PipelineSupervisor::getPipeline() const
+{
+  return prv->getPipeline();
+}
+
+PipelineSupervisor::Stats PipelineSupervisor::getStats() const
+{
+  std::lock_guard lock(prv->mutex);
+  return prv->stats;
+}
+
+void PipelineSupervisor::setBackoff(GstClockTime initial, GstClockTime maximum, double multiplier)
+{
+  if(multiplier < 1.0 || initial > maximum)
+  {
+    throw std::invalid_argument("PipelineSupervisor: invalid backoff");
+  }
+  std::lock_guard lock(prv->mutex);
+  prv->initialBackoff = initial;
+  prv->maxBackoff = maximum;
+  prv->multiplier = multiplier;
+}
+
+void PipelineSupervisor::setJitter(double fraction)
+{
+  if(fraction < 0.0 || fraction > 1.0)
+  {
+    throw std::invalid_argument("PipelineSupervisor: jitter must be in [0, 1]");
+  }
+  std::lock_guard lock(prv->mutex);
+  prv->jitter = fraction;
+}
+
+void PipelineSupervisor::setStableTime(GstClockTime stableTime)
+{
+  std::lock_guard lock(prv->mutex);
+  prv->stableTime = stableTime;
+}
+
+void PipelineSupervisor::setTargetState(GstState state)
+{
+  std::lock_guard lock(prv->mutex);
+  prv->targetState = state;
+}
+
+void PipelineSupervisor::setRestartOnEos(bool restartOnEos)
+{
+  std::lock_guard lock(prv->mutex);
+  prv->restartOnEos = restartOnEos;
+}
+
+void PipelineSupervisor::setStartTimeout(GstClockTime timeout)
+{
+  std::lock_guard lock(prv->mutex);
+  prv->startTimeout = timeout;
+}
+
+} // dh::gst
@@ -0,0 +1,168 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_PIPELINESUPERVISOR_HPP
+#define DH_GST_PIPELINESUPERVISOR_HPP
+
+// local includes
+#include "pipeline.hpp"
+
+// boost
+#include <boost/signals2.hpp>
+
+// std
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+// C
+#include <gst/gst.h>
+
+namespace bs2 = boost::signals2;
+
+namespace dh::gst
+{
+
+/**
+ * @brief Keeps a pipeline running: watches its bus for ERROR (and EOS), tears it down and builds a new one
+ * with exponential backoff and jitter between the attempts.
+ * Teardown is fast, the failed pipeline is set to NULL directly without draining.
+ * The supervisor has an own thread, the signals are emitted from it.
+ *
+ * The bus is watched with a sync-message handler (see gst_bus_enable_sync_message_emission), no message
+ * is popped and no sync handler or watch is installed. So the messages stay on the bus for the application,
+ * which should consume them, e.g. with a BusDispatcher created in a pipelineStartedSignal slot.
+ * Otherwise they are queued until the pipeline is torn down (set to NULL, which flushes the bus).
+ * @code
+ * auto supervisor = PipelineSupervisor::create("rtspsrc location=rtsp://camera1/stream ! decodebin ! fakesink");
+ * supervisor->failureSignal.connect([](const std::string& reason){ std::cerr << reason << std::endl; });
+ * supervisor->start();
+ * @endcode
+ */
+class PipelineSupervisor
+{
+protected:
+  /**
+   * @brief Create a supervisor. No pipeline is built before start().
+   * @param factory creates a new pipeline in NULL state
+   * @throws std::invalid_argument if factory is empty
+   */
+  explicit PipelineSupervisor(std::function<std::shared_ptr<Pipeline>()> factory);
+
+public:
+  using Factory = std::function<std::shared_ptr<Pipeline>()>;
+
+  struct Stats
+  {
+    std::size_t restarts{0};                          ///< successful restarts after a failure
+    std::size_t failures{0};                          ///< errors, EOS (if restarting on EOS) and failed starts
+    unsigned consecutiveFailures{0};                  ///< failures since the last stable run, determines the backoff
+    GstClockTime lastRecoveryTime{GST_CLOCK_TIME_NONE}; ///< from the failure until the new pipeline reached the target state
+    GstClockTime maxRecoveryTime{0};
+    GstClockTime totalDowntime{0};                    ///< sum of the recovery times
+    std::string lastFailure;                          ///< reason of the last failure
+  };
+
+  [[nodiscard]] static std::shared_ptr<PipelineSupervisor> create(Factory factory);
+
+  /**
+   * @brief Create a supervisor for a pipeline description. The description is parsed once into a PipelineTemplate.
+   * @throws std::runtime_error if the description can not be parsed
+   */
+  [[nodiscard]] static std::shared_ptr<PipelineSupervisor> create(const std::string& description);
+
+  /**
+   * @brief stops the supervisor and sets the pipeline to NULL.
+   * Must not be destroyed from one of its signal slots.
+   */
+  ~PipelineSupervisor();
+
+  /**
+   * @brief Build the pipeline and bring it to the target state. Does nothing if already running.
+   * After stop() from a signal slot, the old pipeline is set to NULL here and a new supervisor thread takes over.
+   */
+  void start();
+
+  /**
+   * @brief Stop supervising and set the pipeline to NULL.
+   * Waits for the supervisor thread, unless called from a signal slot.
+   */
+  void stop();
+
+  [[nodiscard]] bool isRunning() const;
+
+  /**
+   * @brief Get the current pipeline.
+   * @return the pipeline or nullptr during a restart
+   */
+  [[nodiscard]] std::shared_ptr<Pipeline> getPipeline() const;
+
+  [[nodiscard]] Stats getStats() const;
+
+  /**
+   * @brief Set the delay between the restart attempts.
+   * The n-th consecutive failure waits initial * multiplier^(n-1), at most maximum.
+   * @param initial delay after the first failure, default 100ms
+   * @param maximum the upper bound, default 30s
+   * @param multiplier growth per failure, default 2
+   * @throws std::invalid_argument if multiplier < 1 or initial > maximum
+   */
+  void setBackoff(GstClockTime initial, GstClockTime maximum, double multiplier = 2.0);
+
+  /**
+   * @brief Randomize the delays, so many supervisors don't reconnect to the same source at once.
+   * @param fraction the delay varies by +-fraction, default 0.2
+   * @throws std::invalid_argument if fraction is not in [0, 1]
+   */
+  void setJitter(double fraction);
+
+  /**
+   * @brief A pipeline that ran at least this long before failing resets the backoff.
+   * @param stableTime the time, default 10s
+   */
+  void setStableTime(GstClockTime stableTime);
+
+  /**
+   * @brief Set the state to bring new pipelines to, default GST_STATE_PLAYING.
+   */
+  void setTargetState(GstState state);
+
+  /**
+   * @brief Also restart on EOS, default true (e.g. a network source that ends on disconnect).
+   */
+  void setRestartOnEos(bool restartOnEos);
+
+  /**
+   * @brief Set the time a new pipeline has to reach the target state, default 10s.
+   */
+  void setStartTimeout(GstClockTime timeout);
+
+  bs2::signal<void(std::shared_ptr<Pipeline>)> pipelineStartedSignal; ///< a new pipeline reached the target state
+  bs2::signal<void(const std::string& reason)> failureSignal;         ///< the pipeline failed and will be rebuilt
+
+private:
+  class Private;
+  std::shared_ptr<Private> prv; // shared with the supervisor thread
+};
+
+} // dh::gst
+
+#endif //DH_GST_PIPELINESUPERVISOR_HPP
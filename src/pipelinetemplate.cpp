@@ -0,0 +1,393 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "pipelinetemplate.hpp"
+
+// std
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dh::gst
+{
+
+namespace
+{
+constexpr const char* parameterStart = "${";
+
+/**
+ * @brief escape the characters that end a value in a pipeline description
+ * Works for quoted and unquoted values, the parser removes the backslashes.
+ */
+std::string escapeValue(const std::string& value)
+{
+  std::string result;
+  result.reserve(value.size());
+  for(const char c : value)
+  {
+    if(g_ascii_isspace(c) || std::string_view("\\\"'!(),;={}").find(c) != std::string_view::npos)
+    {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result;
+}
+
+/**
+ * @brief replace all ${name} in text
+ * @param escape escape the values for a pipeline description, see @ref escapeValue
+ * @throws std::invalid_argument if a parameter has no value
+ */
+std::string substitute(const std::string& text, const PipelineTemplate::Parameters& parameters, bool escape = false)
+{
+  std::string result;
+  std::string::size_type position = 0;
+  while(true)
+  {
+    const auto start = text.find(parameterStart, position);
+    const auto end = start == std::string::npos ? std::string::npos : text.find('}', start + 2);
+    if(end == std::string::npos)
+    {
+      result.append(text, position, std::string::npos);
+      return result;
+    }
+    const std::string name = text.substr(start + 2, end - start - 2);
+    const auto it = parameters.find(name);
+    if(it == parameters.end())
+    {
+      throw std::invalid_argument("PipelineTemplate: no value for parameter '" + name + "'");
+    }
+    result.append(text, position, start - position);
+    result += escape ? escapeValue(it->second) : it->second;
+    position = end + 1;
+  }
+}
+
+bool hasSometimesSrcPads(GstElement* element)
+{
+  for(const GList* item = gst_element_class_get_pad_template_list(GST_ELEMENT_GET_CLASS(element)); item; item = item->next)
+  {
+    const auto* padTemplate = static_cast<GstPadTemplate*>(item->data);
+    if(GST_PAD_TEMPLATE_DIRECTION(padTemplate) == GST_PAD_SRC && GST_PAD_TEMPLATE_PRESENCE(padTemplate) == GST_PAD_SOMETIMES)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+class PipelineTemplate::Private
+{
+public:
+  struct Property
+  {
+    Property(const gchar* name, const GValue& source)
+    : name{name}
+    {
+      g_value_init(&value, G_VALUE_TYPE(&source));
+      g_value_copy(&source, &value);
+      hasParameters = G_VALUE_HOLDS_STRING(&value)
+        && g_value_get_string(&value)
+        && std::string(g_value_get_string(&value)).find(parameterStart) != std::string::npos;
+    }
+
+    Property(Property&& other) noexcept
+    : name{std::move(other.name)}
+    , value{other.value}
+    , hasParameters{other.hasParameters}
+    {
+      other.value = G_VALUE_INIT;
+    }
+
+    Property(const Property&) = delete;
+    Property& operator=(const Property&) = delete;
+    Property& operator=(Property&&) = delete;
+
+    ~Property()
+    {
+      if(G_IS_VALUE(&value))
+      {
+        g_value_unset(&value);
+      }
+    }
+
+    std::string name;
+    GValue value = G_VALUE_INIT;
+    bool hasParameters;
+  };
+
+  struct ElementSpec
+  {
+    GstElementFactorySPtr factory;
+    std::string name;
+    std::vector<Property> properties;
+  };
+
+  struct Link
+  {
+    std::size_t source;
+    std::string sourcePad;
+    std::size_t sink;
+    std::string sinkPad;
+  };
+
+  std::string description;
+  bool compiled{false};
+  std::vector<ElementSpec> elements;
+  std::vector<Link> links;
+
+  static GstPipeline* parse(const std::string& description)
+  {
+    // gst_parse_launch: transfer floating
+    GError* error = nullptr;
+    GstElement* pipeline = gst_parse_launch(description.c_str(), &error);
+    GErrorSPtr errorSPtr(error, GlibDeleter());
+    // a pipeline can be returned with an error, e.g. for an unknown property or an invalid value
+    if(errorSPtr)
+    {
+      if(pipeline)
+      {
+        gst_object_unref(gst_object_ref_sink(pipeline));
+      }
+      throw std::runtime_error(std::string("PipelineTemplate: failed to parse pipeline description: ") + errorSPtr->message);
+    }
+    if(! pipeline)
+    {
+      throw std::runtime_error("PipelineTemplate: failed to create pipeline from description");
+    }
+    if(! GST_IS_PIPELINE(pipeline))
+    {
+      gst_object_unref(gst_object_ref_sink(pipeline));
+      throw std::runtime_error("PipelineTemplate: description does not create a GstPipeline");
+    }
+    return GST_PIPELINE(pipeline);
+  }
+
+  /**
+   * @brief extract the elements, properties and links of the prototype
+   * @return false if the prototype can not be recreated from the extracted graph
+   */
+  bool compile(GstBin* prototype)
+  {
+    std::vector<GstElement*> children;
+    GST_OBJECT_LOCK(prototype);
+    for(const GList* item = GST_BIN_CHILDREN(prototype); item; item = item->next)
+    {
+      // the children list is in reverse order of adding
+      children.insert(children.begin(), GST_ELEMENT_CAST(item->data));
+    }
+    GST_OBJECT_UNLOCK(prototype);
+
+    std::unordered_map<GstElement*, std::size_t> indices;
+    for(GstElement* child : children)
+    {
+      if(GST_IS_BIN(child) || hasSometimesSrcPads(child))
+      {
+        GST_DEBUG("PipelineTemplate: '%s' is a bin or has sometimes pads, can not compile", GST_OBJECT_NAME(child));
+        return false;
+      }
+      GstElementFactory* factory = gst_element_get_factory(child);
+      if(! factory)
+      {
+        return false;
+      }
+      ElementSpec spec;
+      spec.factory = makeGstSharedPtr(factory, TransferType::None);
+      spec.name = GST_OBJECT_NAME(child);
+      if(! extractProperties(child, spec.properties))
+      {
+        return false;
+      }
+      indices.emplace(child, elements.size());
+      elements.push_back(std::move(spec));
+    }
+
+    for(GstElement* child : children)
+    {
+      GST_OBJECT_LOCK(child);
+      std::vector<GstPad*> pads;
+      for(const GList* item = child->srcpads; item; item = item->next)
+      {
+        pads.push_back(GST_PAD_CAST(gst_object_ref(item->data)));
+      }
+      GST_OBJECT_UNLOCK(child);
+
+      bool ok = true;
+      for(GstPad* pad : pads)
+      {
+        // gst_pad_get_peer, gst_pad_get_parent_element: transfer full
+        const auto peer = makeGstSharedPtr(gst_pad_get_peer(pad), TransferType::Full);
+        const auto peerElement = peer ? makeGstSharedPtr(gst_pad_get_parent_element(peer.get()), TransferType::Full) : GstElementSPtr{};
+        if(ok && peer)
+        {
+          const auto it = peerElement ? indices.find(peerElement.get()) : indices.end();
+          if(it == indices.end())
+          {
+            ok = false; // e.g. a ghost pad
+          }
+          else
+          {
+            links.push_back({indices.at(child), GST_PAD_NAME(pad), it->second, GST_PAD_NAME(peer.get())});
+          }
+        }
+        gst_object_unref(pad);
+      }
+      if(! ok)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static bool extractProperties(GstElement* element, std::vector<Property>& properties)
+  {
+    guint count = 0;
+    GParamSpec** specs = g_object_class_list_properties(G_OBJECT_GET_CLASS(element), &count);
+    bool ok = true;
+    for(guint i = 0; i < count && ok; ++i)
+    {
+      GParamSpec* spec = specs[i];
+      if(! (spec->flags & G_PARAM_READABLE) || ! (spec->flags & G_PARAM_WRITABLE) || (spec->flags & G_PARAM_DEPRECATED)
+        || g_str_equal(spec->name, "name") || g_str_equal(spec->name, "parent"))
+      {
+        continue;
+      }
+      GValue value = G_VALUE_INIT;
+      g_value_init(&value, spec->value_type);
+      g_object_get_property(G_OBJECT(element), spec->name, &value);
+      if(! g_param_value_defaults(spec, &value))
+      {
+        if((spec->flags & G_PARAM_CONSTRUCT_ONLY) || G_TYPE_FUNDAMENTAL(spec->value_type) == G_TYPE_OBJECT)
+        {
+          // can not be set after creation or would be shared between the pipelines
+          GST_DEBUG("PipelineTemplate: property '%s' of '%s' can not be compiled", spec->name, GST_OBJECT_NAME(element));
+          ok = false;
+        }
+        else
+        {
+          properties.emplace_back(spec->name, value);
+        }
+      }
+      g_value_unset(&value);
+    }
+    g_free(specs);
+    return ok;
+  }
+
+  GstElement* createElement(const ElementSpec& spec, const Parameters& parameters) const
+  {
+    GstElement* element = gst_element_factory_create(spec.factory.get(), spec.name.c_str());
+    if(! element)
+    {
+      throw std::runtime_error("PipelineTemplate: failed to create element '" + spec.name + "'");
+    }
+    for(const auto& property : spec.properties)
+    {
+      if(property.hasParameters)
+      {
+        const std::string text = substitute(g_value_get_string(&property.value), parameters);
+        g_object_set(G_OBJECT(element), property.name.c_str(), text.c_str(), nullptr);
+      }
+      else
+      {
+        g_object_set_property(G_OBJECT(element), property.name.c_str(), &property.value);
+      }
+    }
+    return element;
+  }
+};
+
+PipelineTemplate::PipelineTemplate(const std::string& description)
+: prv{std::make_unique<Private>()}
+{
+  prv->description = description;
+  auto prototype = makeGstSharedPtr(Private::parse(description), TransferType::Floating);
+  prv->compiled = prv->compile(GST_BIN_CAST(prototype.get()));
+  if(! prv->compiled)
+  {
+    prv->elements.clear();
+    prv->links.clear();
+    GST_INFO("PipelineTemplate: description is parsed for every instance: '%s'", description.c_str());
+  }
+}
+
+PipelineTemplate::~PipelineTemplate() = default;
+
+std::shared_ptr<PipelineTemplate> PipelineTemplate::create(const std::string& description)
+{
+  return std::shared_ptr<PipelineTemplate>(new PipelineTemplate(description));
+}
+
+std::shared_ptr<Pipeline> PipelineTemplate::instantiate(const Parameters& parameters, const std::string& name) const
+{
+  if(! prv->compiled)
+  {
+    auto pipeline = Pipeline::create(Private::parse(substitute(prv->description, parameters, true)), TransferType::Floating);
+    if(! name.empty())
+    {
+      gst_object_set_name(GST_OBJECT_CAST(pipeline->getGstPipeline().get()), name.c_str());
+    }
+    return pipeline;
+  }
+
+  auto pipeline = Pipeline::create(name);
+  GstBin* bin = GST_BIN_CAST(pipeline->getGstPipeline().get());
+  std::vector<GstElement*> elements;
+  elements.reserve(prv->elements.size());
+  for(const auto& spec : prv->elements)
+  {
+    // the bin takes the floating reference
+    GstElement* element = prv->createElement(spec, parameters);
+    gst_bin_add(bin, element);
+    elements.push_back(element);
+  }
+
+  for(const auto& link : prv->links)
+  {
+    if(! gst_element_link_pads(
+      elements[link.source], link.sourcePad.c_str(),
+      elements[link.sink], link.sinkPad.c_str()))
+    {
+      throw std::runtime_error(
+        "PipelineTemplate: failed to link " + prv->elements[link.source].name + ":" + link.sourcePad
+        + " to " + prv->elements[link.sink].name + ":" + link.sinkPad
+      );
+    }
+  }
+  return pipeline;
+}
+
+bool PipelineTemplate::isCompiled() const
+{
+  return prv->compiled;
+}
+
+const std::string& PipelineTemplate::getDescription() const
+{
+  return prv->description;
+}
+
+} // dh::gst
@@ -0,0 +1,98 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_PIPELINETEMPLATE_HPP
+#define DH_GST_PIPELINETEMPLATE_HPP
+
+// local includes
+#include "pipeline.hpp"
+
+// std
+#include <map>
+#include <memory>
+#include <string>
+
+// C
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Parses a pipeline description once and creates any number of pipelines from it.
+ * The description is parsed into a prototype pipeline, from which the element factories,
+ * the properties that differ from their defaults (as GValues) and the links are extracted.
+ * Instantiating creates the elements directly from the factories, no lexing, parsing or factory lookup by name.
+ *
+ * String properties can contain parameters in the form ${name}, which are replaced on instantiation:
+ * @code
+ * auto recordingTemplate = PipelineTemplate::create("filesrc location=\"${file}\" ! queue ! fakesink");
+ * auto pipeline = recordingTemplate->instantiate({{"file", "/recordings/camera1.ts"}});
+ * @endcode
+ *
+ * Descriptions with bins, elements with sometimes pads (e.g. rtspsrc or decodebin, the links are made at runtime)
+ * or object properties can not be compiled. For them, instantiate() substitutes the parameters
+ * in the description and parses it again, see @ref isCompiled. The values are escaped for the parser,
+ * so a value with spaces, quotes or '!' stays one property value.
+ */
+class PipelineTemplate
+{
+protected:
+  /**
+   * @brief Parse the description.
+   * @param description a pipeline description like for gst-launch-1.0
+   * @throws std::runtime_error if the description can not be parsed, including unknown properties or invalid values
+   */
+  explicit PipelineTemplate(const std::string& description);
+
+public:
+  using Parameters = std::map<std::string, std::string>;
+
+  [[nodiscard]] static std::shared_ptr<PipelineTemplate> create(const std::string& description);
+
+  ~PipelineTemplate();
+
+  /**
+   * @brief Create a new pipeline.
+   * @param parameters the values of the ${name} parameters
+   * @param name the name of the pipeline, empty for a generated name
+   * @return the new pipeline in NULL state
+   * @throws std::invalid_argument if a parameter has no value
+   * @throws std::runtime_error if the pipeline can not be created, e.g. a value is invalid for a
+   * non-string property of a description that is parsed again
+   */
+  [[nodiscard]] std::shared_ptr<Pipeline> instantiate(const Parameters& parameters = {}, const std::string& name = "") const;
+
+  /**
+   * @brief Check if pipelines are created from the extracted graph.
+   * @return false if instantiate() parses the description again
+   */
+  [[nodiscard]] bool isCompiled() const;
+
+  [[nodiscard]] const std::string& getDescription() const;
+
+private:
+  class Private;
+  std::unique_ptr<Private> prv;
+};
+
+} // dh::gst
+
+#endif //DH_GST_PIPELINETEMPLATE_HPP
@@ -0,0 +1,237 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "positioncache.hpp"
+
+// std
+#include <algorithm>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace dh::gst
+{
+
+namespace
+{
+// the duration rarely changes, it is queried on every n-th update only once known
+constexpr unsigned durationUpdateDivider = 10;
+} // namespace
+
+PositionCache::Position::Position(GstPipeline* pipeline)
+{
+  g_weak_ref_init(&this->pipeline, pipeline);
+}
+
+PositionCache::Position::~Position()
+{
+  g_weak_ref_clear(&pipeline);
+}
+
+GstClockTime PositionCache::Position::getPosition() const noexcept
+{
+  return position.load(std::memory_order_relaxed);
+}
+
+GstClockTime PositionCache::Position::getDuration() const noexcept
+{
+  return duration.load(std::memory_order_relaxed);
+}
+
+GstClockTime PositionCache::Position::getUpdateTime() const noexcept
+{
+  return updateTime.load(std::memory_order_relaxed);
+}
+
+void PositionCache::Position::update(GstClockTime now, bool queryDuration)
+{
+  // g_weak_ref_get: transfer full, nullable
+  auto* element = static_cast<GstElement*>(g_weak_ref_get(&pipeline));
+  if(! element)
+  {
+    return;
+  }
+  gint64 value = -1;
+  position.store(gst_element_query_position(element, GST_FORMAT_TIME, &value) ? static_cast<GstClockTime>(value) : GST_CLOCK_TIME_NONE, std::memory_order_relaxed);
+  if(queryDuration || ! GST_CLOCK_TIME_IS_VALID(duration.load(std::memory_order_relaxed)))
+  {
+    duration.store(gst_element_query_duration(element, GST_FORMAT_TIME, &value) ? static_cast<GstClockTime>(value) : GST_CLOCK_TIME_NONE, std::memory_order_relaxed);
+  }
+  updateTime.store(now, std::memory_order_relaxed);
+  gst_object_unref(element);
+}
+
+class PositionCache::Private
+{
+public:
+  using Positions = std::vector<std::weak_ptr<Position>>;
+
+  GstClockSPtr clock;
+  GstClockTime interval{0};
+  GstClockID clockId{nullptr};
+
+  mutable std::mutex mutex;
+  // copy on write, so the updates run without holding the lock
+  std::shared_ptr<const Positions> positions{std::make_shared<Positions>()};
+  std::mutex updateMutex; // refresh() and the worker
+  unsigned updateCount{0};
+
+  // the clock callback only triggers the worker, the async thread of the clock is shared by all waits
+  std::mutex workerMutex;
+  std::condition_variable workerCondition;
+  bool running{true};
+  bool triggered{false};
+  std::thread worker;
+
+  void trigger()
+  {
+    std::lock_guard lock(workerMutex);
+    // ticks during a running update are merged into one
+    triggered = true;
+    workerCondition.notify_one();
+  }
+
+  void run()
+  {
+    std::unique_lock lock(workerMutex);
+    while(true)
+    {
+      workerCondition.wait(lock, [this]{ return triggered || ! running; });
+      if(! running)
+      {
+        return;
+      }
+      triggered = false;
+      lock.unlock();
+      update();
+      lock.lock();
+    }
+  }
+
+  std::shared_ptr<const Positions> getPositions() const
+  {
+    std::lock_guard lock(mutex);
+    return positions;
+  }
+
+  void update()
+  {
+    const auto current = getPositions();
+    std::lock_guard lock(updateMutex);
+    const GstClockTime now = gst_clock_get_time(clock.get());
+    const bool queryDuration = updateCount++ % durationUpdateDivider == 0;
+    for(const auto& weakPosition : *current)
+    {
+      if(const auto position = weakPosition.lock())
+      {
+        position->update(now, queryDuration);
+      }
+    }
+  }
+};
+
+PositionCache::PositionCache(GstClockTime interval, GstClockSPtr clock)
+: prv{std::make_shared<Private>()}
+{
+  if(interval == 0 || ! GST_CLOCK_TIME_IS_VALID(interval))
+  {
+    throw std::invalid_argument("PositionCache: invalid interval");
+  }
+  prv->interval = interval;
+  prv->clock = clock ? std::move(clock) : makeGstSharedPtr(gst_system_clock_obtain(), TransferType::Full);
+  prv->worker = std::thread([prv = prv]{ prv->run(); });
+  prv->clockId = gst_clock_new_periodic_id(prv->clock.get(), gst_clock_get_time(prv->clock.get()) + interval, interval);
+  gst_clock_id_wait_async(
+    prv->clockId,
+    [](GstClock*, GstClockTime, GstClockID, gpointer data) -> gboolean
+    {
+      (*static_cast<std::shared_ptr<Private>*>(data))->trigger();
+      return TRUE;
+    },
+    new std::shared_ptr<Private>(prv),
+    [](gpointer data){ delete static_cast<std::shared_ptr<Private>*>(data); }
+  );
+}
+
+PositionCache::~PositionCache()
+{
+  gst_clock_id_unschedule(prv->clockId);
+  gst_clock_id_unref(prv->clockId);
+  {
+    std::lock_guard lock(prv->workerMutex);
+    prv->running = false;
+    prv->workerCondition.notify_one();
+  }
+  prv->worker.join();
+}
+
+std::shared_ptr<PositionCache> PositionCache::create(GstClockTime interval, GstClockSPtr clock)
+{
+  return std::shared_ptr<PositionCache>(new PositionCache(interval, std::move(clock)));
+}
+
+std::shared_ptr<const PositionCache::Position> PositionCache::add(const std::shared_ptr<Pipeline>& pipeline)
+{
+  if(! pipeline)
+  {
+    throw std::invalid_argument("PositionCache: no pipeline given");
+  }
+  auto position = std::make_shared<Position>(pipeline->getGstPipeline().get());
+
+  std::lock_guard lock(prv->mutex);
+  auto newPositions = std::make_shared<Private::Positions>();
+  newPositions->reserve(prv->positions->size() + 1);
+  // drop the registrations of destroyed positions
+  std::copy_if(
+    prv->positions->begin(),
+    prv->positions->end(),
+    std::back_inserter(*newPositions),
+    [](const auto& existing){ return ! existing.expired(); }
+  );
+  newPositions->push_back(position);
+  prv->positions = std::move(newPositions);
+  return position;
+}
+
+void PositionCache::refresh()
+{
+  prv->update();
+}
+
+std::size_t PositionCache::getPipelineCount() const
+{
+  const auto positions = prv->getPositions();
+  return static_cast<std::size_t>(std::count_if(
+    positions->begin(),
+    positions->end(),
+    [](const auto& position){ return ! position.expired(); }
+  ));
+}
+
+GstClockTime PositionCache::getInterval() const
+{
+  return prv->interval;
+}
+
+} // dh::gst
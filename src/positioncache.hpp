@@ -0,0 +1,125 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_POSITIONCACHE_HPP
+#define DH_GST_POSITIONCACHE_HPP
+
+// local includes
+#include "pipeline.hpp"
+#include "sharedptrs.hpp"
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// C
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Queries position and duration of many pipelines periodically and caches the values,
+ * so readers (UI, dashboards) only do an atomic load instead of a query through the pipeline.
+ * The updates are driven by a periodic clock id. Its callback only wakes up a worker thread of the cache,
+ * which runs the queries, so slow queries do not delay the other async waits on the clock (they share
+ * one async thread). Ticks while an update is still running are merged into one update.
+ * @code
+ * auto cache = PositionCache::create(200 * GST_MSECOND);
+ * auto position = cache->add(pipeline); // keep it, the registration ends with it
+ * // any thread:
+ * GstClockTime now = position->getPosition();
+ * @endcode
+ */
+class PositionCache
+{
+protected:
+  /**
+   * @brief Start the periodic updates.
+   * @param interval time between two updates
+   * @param clock the clock driving the updates, the system clock if empty
+   * @throws std::invalid_argument if interval is 0 or invalid
+   */
+  PositionCache(GstClockTime interval, GstClockSPtr clock);
+
+public:
+  /**
+   * @brief the cached values of one pipeline, GST_CLOCK_TIME_NONE if unknown
+   */
+  class Position
+  {
+  public:
+    explicit Position(GstPipeline* pipeline);
+    ~Position();
+    Position(const Position&) = delete;
+    Position& operator=(const Position&) = delete;
+
+    [[nodiscard]] GstClockTime getPosition() const noexcept;
+    [[nodiscard]] GstClockTime getDuration() const noexcept;
+
+    /**
+     * @brief Get the time of the last update.
+     * @return the time of the clock driving the updates
+     */
+    [[nodiscard]] GstClockTime getUpdateTime() const noexcept;
+
+  private:
+    friend class PositionCache;
+    void update(GstClockTime now, bool queryDuration);
+
+    GWeakRef pipeline; // the cache does not keep pipelines alive
+    std::atomic<GstClockTime> position{GST_CLOCK_TIME_NONE};
+    std::atomic<GstClockTime> duration{GST_CLOCK_TIME_NONE};
+    std::atomic<GstClockTime> updateTime{GST_CLOCK_TIME_NONE};
+  };
+
+  [[nodiscard]] static std::shared_ptr<PositionCache> create(GstClockTime interval = 100 * GST_MSECOND, GstClockSPtr clock = {});
+
+  /**
+   * @brief stops the updates and waits for the worker thread.
+   */
+  ~PositionCache();
+
+  /**
+   * @brief Register a pipeline. It is updated until the returned Position is destroyed.
+   * The values are filled with the next update.
+   * @param pipeline the pipeline
+   * @return the cached values
+   * @throws std::invalid_argument if pipeline is empty
+   */
+  [[nodiscard]] std::shared_ptr<const Position> add(const std::shared_ptr<Pipeline>& pipeline);
+
+  /**
+   * @brief Update all pipelines now, in the calling thread.
+   */
+  void refresh();
+
+  [[nodiscard]] std::size_t getPipelineCount() const;
+  [[nodiscard]] GstClockTime getInterval() const;
+
+private:
+  class Private;
+  std::shared_ptr<Private> prv; // shared with the clock callback and the worker thread
+};
+
+} // dh::gst
+
+#endif //DH_GST_POSITIONCACHE_HPP
@@ -96,6 +96,10 @@ struct GstObjectDeleter
       {
         gst_sample_unref(obj);
       }
+      else if constexpr(std::is_same_v<T, GstQuery>)
+      {
+        gst_query_unref(obj);
+      }
       else
       {
         // Static assert for unhandled types to ensure all cases are covered
@@ -125,6 +129,7 @@ using GstIteratorSPtr = std::shared_ptr<GstIterator>;
 using GstPadTemplateSPtr = std::shared_ptr<GstPadTemplate>;
 using GstPipelineSPtr = std::shared_ptr<GstPipeline>;
 using GstPluginSPtr = std::shared_ptr<GstPlugin>;
+using GstQuerySPtr = std::shared_ptr<GstQuery>;
 using GstSampleSPtr = std::shared_ptr<GstSample>;
 using GstStructureSPtr = std::shared_ptr<GstStructure>;
 using GstPluginFeatureSPtr = std::shared_ptr<GstPluginFeature>;
@@ -198,6 +203,10 @@ makeGstSharedPtr(T* obj, TransferType transferType)
     {
       gst_buffer_ref(obj);
     }
+    else if constexpr(std::is_same_v<T, GstQuery>)
+    {
+      gst_query_ref(obj);
+    }
     else
     {
       // Static assert for unhandled types to ensure all cases are covered
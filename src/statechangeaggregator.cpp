@@ -0,0 +1,162 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "statechangeaggregator.hpp"
+
+// std
+#include <mutex>
+#include <stdexcept>
+
+namespace dh::gst
+{
+
+class StateChangeAggregator::Private
+{
+public:
+  GstBinSPtr bin;
+  std::mutex mutex;
+  bool keepElementChanges{true};
+  bool inTransition{false};
+  StateTransition transition; // reused, keeps the capacity of elementChanges
+
+  bool isOwnElement(GstObject* source) const
+  {
+    auto* binObject = GST_OBJECT_CAST(bin.get());
+    return source && (source == binObject || gst_object_has_as_ancestor(source, binObject));
+  }
+
+  void clear()
+  {
+    inTransition = false;
+    transition.oldState = GST_STATE_VOID_PENDING;
+    transition.newState = GST_STATE_VOID_PENDING;
+    transition.started = GST_CLOCK_TIME_NONE;
+    transition.duration = 0;
+    transition.elementChanges.clear();
+  }
+};
+
+StateChangeAggregator::StateChangeAggregator(std::shared_ptr<Bin> bin)
+: prv{std::make_unique<Private>()}
+{
+  if(! bin)
+  {
+    throw std::invalid_argument("StateChangeAggregator: no bin given");
+  }
+  prv->bin = bin->getGstBin();
+}
+
+StateChangeAggregator::~StateChangeAggregator() = default;
+
+std::shared_ptr<StateChangeAggregator> StateChangeAggregator::create(std::shared_ptr<Bin> bin)
+{
+  return std::shared_ptr<StateChangeAggregator>(new StateChangeAggregator(std::move(bin)));
+}
+
+bs2::connection StateChangeAggregator::connect(MessageParser& parser)
+{
+  return parser.stateChangedRecordSignal.connectNamed(
+    "StateChangeAggregator",
+    [weakSelf = weak_from_this()](const StateChangedRecord& record)
+    {
+      if(const auto self = weakSelf.lock())
+      {
+        self->handle(record);
+      }
+    }
+  );
+}
+
+void StateChangeAggregator::handle(const StateChangedRecord& record)
+{
+  GstObject* source = GST_MESSAGE_SRC(&record.message);
+  if(! prv->isOwnElement(source))
+  {
+    return;
+  }
+
+  std::unique_lock lock(prv->mutex);
+  const GstClockTime now = gst_util_get_timestamp();
+  if(! prv->inTransition)
+  {
+    prv->inTransition = true;
+    prv->transition.started = now;
+  }
+
+  const bool isBin = source == GST_OBJECT_CAST(prv->bin.get());
+  if(isBin && prv->transition.oldState == GST_STATE_VOID_PENDING)
+  {
+    prv->transition.oldState = record.oldState;
+  }
+
+  if(prv->keepElementChanges)
+  {
+    // the quark is created once per element name, later lookups do not allocate
+    const GQuark name = g_quark_from_string(GST_OBJECT_NAME(source) ? GST_OBJECT_NAME(source) : "unknown");
+    prv->transition.elementChanges.push_back({name, record.oldState, record.newState, now - prv->transition.started});
+  }
+
+  if(! isBin || record.pendingState != GST_STATE_VOID_PENDING)
+  {
+    return;
+  }
+
+  prv->transition.newState = record.newState;
+  prv->transition.duration = now - prv->transition.started;
+  GST_DEBUG_OBJECT(
+    prv->bin.get(),
+    "transition %s -> %s took %" GST_TIME_FORMAT " with %zu element state changes",
+    gst_element_state_get_name(prv->transition.oldState),
+    gst_element_state_get_name(prv->transition.newState),
+    GST_TIME_ARGS(prv->transition.duration),
+    prv->transition.elementChanges.size()
+  );
+
+  // emit without the lock, the slots may call reset() or setKeepElementChanges()
+  StateTransition completed;
+  std::swap(completed, prv->transition);
+  prv->clear();
+  lock.unlock();
+
+  transitionSignal(completed);
+
+  // give the capacity back, unless the next transition has already started to fill the swapped in vector
+  lock.lock();
+  if(prv->transition.elementChanges.empty())
+  {
+    completed.elementChanges.clear();
+    std::swap(prv->transition.elementChanges, completed.elementChanges);
+  }
+}
+
+void StateChangeAggregator::setKeepElementChanges(bool keep)
+{
+  std::lock_guard lock(prv->mutex);
+  prv->keepElementChanges = keep;
+}
+
+void StateChangeAggregator::reset()
+{
+  std::lock_guard lock(prv->mutex);
+  prv->clear();
+}
+
+} // dh::gst
@@ -0,0 +1,125 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_STATECHANGEAGGREGATOR_HPP
+#define DH_GST_STATECHANGEAGGREGATOR_HPP
+
+// local includes
+#include "bin.hpp"
+#include "messageparser.hpp"
+#include "sharedptrs.hpp"
+
+// boost
+#include <boost/signals2.hpp>
+
+// std
+#include <memory>
+#include <vector>
+
+// C
+#include <gst/gst.h>
+
+namespace bs2 = boost::signals2;
+
+namespace dh::gst
+{
+
+/**
+ * @brief A completed state transition of a pipeline (or bin), with the state changes of its elements.
+ */
+struct StateTransition
+{
+  struct ElementChange
+  {
+    GQuark elementName;  ///< use g_quark_to_string() to get the name
+    GstState oldState;
+    GstState newState;
+    GstClockTime offset; ///< time since the first state change of the transition
+  };
+
+  GstState oldState{GST_STATE_VOID_PENDING}; ///< state of the pipeline before the transition
+  GstState newState{GST_STATE_VOID_PENDING}; ///< state of the pipeline after the transition
+  GstClockTime started{GST_CLOCK_TIME_NONE}; ///< monotonic time (gst_util_get_timestamp) of the first state change
+  GstClockTime duration{0};                  ///< time from the first state change to the final pipeline state change
+  std::vector<ElementChange> elementChanges; ///< empty if disabled with StateChangeAggregator::setKeepElementChanges
+};
+
+/**
+ * @brief Collapses the STATE_CHANGED messages of a pipeline and all of its elements into one transition event.
+ * A transition starts with the first state change of an element and ends with the state change of the pipeline
+ * that has no pending state left, e.g. NULL -> PLAYING is one transition even though it takes three steps.
+ * Connect it to the MessageParser of the pipeline bus instead of @ref MessageParser::stateChangedSignal,
+ * then the per element messages cost no string conversions and no allocations after the first transition.
+ */
+class StateChangeAggregator : public std::enable_shared_from_this<StateChangeAggregator>
+{
+protected:
+  /**
+   * @brief Create an aggregator for the given pipeline or bin.
+   * @param bin the bin, usually the Pipeline, state changes of other elements are ignored
+   * @throws std::invalid_argument if bin is empty
+   */
+  explicit StateChangeAggregator(std::shared_ptr<Bin> bin);
+
+public:
+  [[nodiscard]] static std::shared_ptr<StateChangeAggregator> create(std::shared_ptr<Bin> bin);
+
+  ~StateChangeAggregator();
+
+  /**
+   * @brief Feed the state changes of the parser into the aggregator.
+   * The connection only keeps a weak reference, the aggregator ignores messages after it is destroyed.
+   * @param parser the parser that gets the bus messages of the pipeline
+   * @return the connection to @ref MessageParser::stateChangedRecordSignal
+   */
+  bs2::connection connect(MessageParser& parser);
+
+  /**
+   * @brief Handle one STATE_CHANGED message, emits @ref transitionSignal if the transition is complete.
+   * @param record the state change
+   */
+  void handle(const StateChangedRecord& record);
+
+  /**
+   * @brief Keep the state changes of the elements in the transition. Default: true
+   * @param keep false to only report the pipeline transition
+   */
+  void setKeepElementChanges(bool keep);
+
+  /**
+   * @brief Forget the state changes of the current transition, e.g. after an error.
+   */
+  void reset();
+
+  /**
+   * @brief Emitted when the pipeline has reached its target state.
+   * The transition is only valid during the emission. It is emitted without holding the internal lock,
+   * so the slots can call the other functions of the aggregator.
+   */
+  bs2::signal<void(const StateTransition& transition)> transitionSignal;
+
+private:
+  class Private;
+  std::unique_ptr<Private> prv;
+};
+
+} // dh::gst
+
+#endif //DH_GST_STATECHANGEAGGREGATOR_HPP
@@ -0,0 +1,307 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// local includes
+#include "statetransitionprofiler.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace dh::gst
+{
+
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+namespace
+{
+/**
+ * @brief the tracer object the hooks are registered for, the hooks can not be removed again
+ */
+struct DhGstStateTracer
+{
+  GstTracer parent;
+};
+
+struct DhGstStateTracerClass
+{
+  GstTracerClass parentClass;
+};
+
+G_DEFINE_TYPE(DhGstStateTracer, dh_gst_state_tracer, GST_TYPE_TRACER)
+
+void dh_gst_state_tracer_class_init(DhGstStateTracerClass* /*klass*/)
+{
+}
+
+void dh_gst_state_tracer_init(DhGstStateTracer* /*tracer*/)
+{
+}
+} // namespace
+#endif
+
+class StateTransitionProfiler::Private
+{
+public:
+  struct Pending
+  {
+    std::string elementName;
+    GstClockTime start;
+    bool isBin;
+    bool async{false};
+  };
+
+  std::shared_ptr<Bin> bin;
+  GstElement* gstBin{nullptr}; // kept alive by bin
+
+  mutable std::mutex mutex;
+  bool recording{false};
+  GstClockTime origin{GST_CLOCK_TIME_NONE};
+  std::map<std::pair<GstElement*, GstStateChange>, Pending> pending;
+  std::vector<Entry> entries;
+
+  // the hooks are called for all elements of the process
+  static std::mutex registryMutex;
+  static std::vector<Private*> registry;
+  static std::atomic<unsigned> recordingCount;
+
+  bool isWatched(GstElement* element) const
+  {
+    return element == gstBin || gst_object_has_as_ancestor(GST_OBJECT_CAST(element), GST_OBJECT_CAST(gstBin));
+  }
+
+  void onChangeStatePre(guint64 timestamp, GstElement* element, GstStateChange transition)
+  {
+    if(! isWatched(element))
+    {
+      return;
+    }
+    std::lock_guard lock(mutex);
+    if(! GST_CLOCK_TIME_IS_VALID(origin))
+    {
+      origin = timestamp;
+    }
+    pending[{element, transition}] = {GST_OBJECT_NAME(element), timestamp, GST_IS_BIN(element)};
+  }
+
+  void onChangeStatePost(guint64 timestamp, GstElement* element, GstStateChange transition, GstStateChangeReturn result)
+  {
+    std::lock_guard lock(mutex);
+    const auto it = pending.find({element, transition});
+    if(it == pending.end())
+    {
+      return;
+    }
+    if(result == GST_STATE_CHANGE_ASYNC)
+    {
+      it->second.async = true;
+      return;
+    }
+    finish(it, result, timestamp);
+  }
+
+  void onPostMessage(guint64 timestamp, GstElement* element, GstMessage* message)
+  {
+    if(GST_MESSAGE_TYPE(message) != GST_MESSAGE_STATE_CHANGED || GST_MESSAGE_SRC(message) != GST_OBJECT_CAST(element))
+    {
+      return;
+    }
+    GstState oldState;
+    GstState newState;
+    gst_message_parse_state_changed(message, &oldState, &newState, nullptr);
+
+    std::lock_guard lock(mutex);
+    const auto it = pending.find({element, GST_STATE_TRANSITION(oldState, newState)});
+    if(it != pending.end() && it->second.async)
+    {
+      finish(it, GST_STATE_CHANGE_ASYNC, timestamp);
+    }
+  }
+
+  void finish(std::map<std::pair<GstElement*, GstStateChange>, Pending>::iterator it, GstStateChangeReturn result, guint64 timestamp)
+  {
+    entries.push_back({
+      std::move(it->second.elementName),
+      it->first.second,
+      result,
+      it->second.start - origin,
+      timestamp > it->second.start ? timestamp - it->second.start : 0,
+      it->second.isBin
+    });
+    pending.erase(it);
+  }
+
+  template<typename Function>
+  static void dispatch(Function function)
+  {
+    if(recordingCount.load(std::memory_order_relaxed) == 0)
+    {
+      return;
+    }
+    std::lock_guard lock(registryMutex);
+    for(Private* profiler : registry)
+    {
+      function(*profiler);
+    }
+  }
+
+  static void registerHooks()
+  {
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+    static std::once_flag once;
+    std::call_once(
+      once,
+      []
+      {
+        // lives until the end of the process, like the hooks
+        auto* tracer = static_cast<GstTracer*>(gst_object_ref_sink(g_object_new(dh_gst_state_tracer_get_type(), nullptr)));
+        gst_tracing_register_hook(
+          tracer,
+          "element-change-state-pre",
+          G_CALLBACK(+[](GstTracer*, guint64 timestamp, GstElement* element, GstStateChange transition)
+          {
+            dispatch([&](Private& profiler){ profiler.onChangeStatePre(timestamp, element, transition); });
+          })
+        );
+        gst_tracing_register_hook(
+          tracer,
+          "element-change-state-post",
+          G_CALLBACK(+[](GstTracer*, guint64 timestamp, GstElement* element, GstStateChange transition, GstStateChangeReturn result)
+          {
+            dispatch([&](Private& profiler){ profiler.onChangeStatePost(timestamp, element, transition, result); });
+          })
+        );
+        gst_tracing_register_hook(
+          tracer,
+          "element-post-message-pre",
+          G_CALLBACK(+[](GstTracer*, guint64 timestamp, GstElement* element, GstMessage* message)
+          {
+            dispatch([&](Private& profiler){ profiler.onPostMessage(timestamp, element, message); });
+          })
+        );
+      }
+    );
+#else
+    throw std::runtime_error("StateTransitionProfiler: GStreamer is built without tracer hooks");
+#endif
+  }
+};
+
+std::mutex StateTransitionProfiler::Private::registryMutex;
+std::vector<StateTransitionProfiler::Private*> StateTransitionProfiler::Private::registry;
+std::atomic<unsigned> StateTransitionProfiler::Private::recordingCount{0};
+
+StateTransitionProfiler::StateTransitionProfiler(std::shared_ptr<Bin> bin)
+: prv{std::make_unique<Private>()}
+{
+  if(! bin)
+  {
+    throw std::invalid_argument("StateTransitionProfiler: no bin given");
+  }
+  Private::registerHooks();
+  prv->gstBin = GST_ELEMENT_CAST(bin->getGstBin().get());
+  prv->bin = std::move(bin);
+}
+
+StateTransitionProfiler::~StateTransitionProfiler()
+{
+  stop();
+}
+
+std::shared_ptr<StateTransitionProfiler> StateTransitionProfiler::create(std::shared_ptr<Bin> bin)
+{
+  return std::shared_ptr<StateTransitionProfiler>(new StateTransitionProfiler(std::move(bin)));
+}
+
+void StateTransitionProfiler::start()
+{
+  std::lock_guard registryLock(Private::registryMutex);
+  {
+    std::lock_guard lock(prv->mutex);
+    prv->pending.clear();
+    prv->entries.clear();
+    prv->origin = GST_CLOCK_TIME_NONE;
+    if(prv->recording)
+    {
+      return;
+    }
+    prv->recording = true;
+  }
+  Private::registry.push_back(prv.get());
+  ++Private::recordingCount;
+}
+
+void StateTransitionProfiler::stop()
+{
+  // after this, no hook uses prv any more
+  std::lock_guard registryLock(Private::registryMutex);
+  std::lock_guard lock(prv->mutex);
+  if(! prv->recording)
+  {
+    return;
+  }
+  prv->recording = false;
+  prv->pending.clear();
+  Private::registry.erase(std::remove(Private::registry.begin(), Private::registry.end(), prv.get()), Private::registry.end());
+  --Private::recordingCount;
+}
+
+bool StateTransitionProfiler::isRecording() const
+{
+  std::lock_guard lock(prv->mutex);
+  return prv->recording;
+}
+
+std::vector<StateTransitionProfiler::Entry> StateTransitionProfiler::getReport() const
+{
+  std::vector<Entry> report;
+  {
+    std::lock_guard lock(prv->mutex);
+    report = prv->entries;
+  }
+  std::stable_sort(
+    report.begin(),
+    report.end(),
+    [](const Entry& a, const Entry& b)
+    {
+      return a.duration > b.duration;
+    }
+  );
+  return report;
+}
+
+void StateTransitionProfiler::dump(std::ostream& stream) const
+{
+  for(const auto& entry : getReport())
+  {
+    stream << entry.elementName
+           << ' ' << gst_state_change_get_name(entry.transition)
+           << ' ' << static_cast<double>(entry.duration) / GST_MSECOND << "ms"
+           << " at " << static_cast<double>(entry.start) / GST_MSECOND << "ms"
+           << ' ' << gst_element_state_change_return_get_name(entry.result)
+           << (entry.isBin ? " (bin, includes children)" : "")
+           << '\n';
+  }
+}
+
+} // dh::gst
@@ -0,0 +1,110 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/* Copyright (C) 2024 Sandro Stiller <sandro.stiller@dragonhills.de>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This file is part of Libdhgst <https://dragonhills.de/>.
+ *
+ * Libdhgst is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * Libdhgst is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Libdhgst. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DH_GST_STATETRANSITIONPROFILER_HPP
+#define DH_GST_STATETRANSITIONPROFILER_HPP
+
+// local includes
+#include "bin.hpp"
+
+// std
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// C
+#include <gst/gst.h>
+
+namespace dh::gst
+{
+
+/**
+ * @brief Measures how long each element of a bin (or pipeline) spends in each state transition.
+ * The start and end of the change_state of every element are taken from the GStreamer tracer hooks,
+ * ASYNC transitions (e.g. the preroll of sinks) end with the STATE_CHANGED message of the element.
+ * The hooks are registered process wide on first use. While no profiler records, they return immediately.
+ * @code
+ * auto profiler = StateTransitionProfiler::create(pipeline);
+ * profiler->start();
+ * pipeline->setState(GST_STATE_PLAYING);
+ * (void)pipeline->getState(10 * GST_SECOND);
+ * profiler->stop();
+ * profiler->dump(std::cout);
+ * @endcode
+ */
+class StateTransitionProfiler
+{
+protected:
+  /**
+   * @brief Create a profiler for the bin and all elements in it. Recording is not started.
+   * @param bin the bin, usually a pipeline
+   * @throws std::invalid_argument if bin is empty
+   * @throws std::runtime_error if GStreamer is built without tracer hooks
+   */
+  explicit StateTransitionProfiler(std::shared_ptr<Bin> bin);
+
+public:
+  struct Entry
+  {
+    std::string elementName;
+    GstStateChange transition;
+    GstStateChangeReturn result; ///< result of the change_state, ASYNC if it was completed later
+    GstClockTime start;          ///< time since the start of the recording
+    GstClockTime duration;
+    bool isBin;                  ///< the duration includes the transitions of the children
+  };
+
+  [[nodiscard]] static std::shared_ptr<StateTransitionProfiler> create(std::shared_ptr<Bin> bin);
+
+  ~StateTransitionProfiler();
+
+  /**
+   * @brief Start recording. Clears the previous results.
+   */
+  void start();
+
+  /**
+   * @brief Stop recording. Transitions that did not finish are dropped.
+   */
+  void stop();
+
+  [[nodiscard]] bool isRecording() const;
+
+  /**
+   * @brief Get the finished transitions, longest first.
+   * @return the entries
+   */
+  [[nodiscard]] std::vector<Entry> getReport() const;
+
+  /**
+   * @brief Write the report as text, one transition per line.
+   * @param stream the stream to write to
+   */
+  void dump(std::ostream& stream) const;
+
+private:
+  class Private;
+  std::unique_ptr<Private> prv;
+};
+
+} // dh::gst
+
+#endif //DH_GST_STATETRANSITIONPROFILER_HPP
@@ -0,0 +1,114 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_appsrctimestamper.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-14
+ */
+
+#include "appsrctimestamper.hpp"
+#include "elementfactory.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace dh::gst;
+
+class AppSrcTimestamperTest
+{
+public:
+  // Setup before first test case
+  AppSrcTimestamperTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(RejectsNonAppSrc, AppSrcTimestamperTest)
+{
+  auto fakeSrc = ElementFactory::makeElement("fakesrc");
+  BOOST_CHECK_THROW((void)AppSrcTimestamper::create(fakeSrc), std::invalid_argument);
+}
+
+BOOST_FIXTURE_TEST_CASE(FirstBufferIsDiscontinuous, AppSrcTimestamperTest)
+{
+  auto timestamper = AppSrcTimestamper::create(ElementFactory::makeElement("appsrc"));
+  auto buffer = makeGstSharedPtr(gst_buffer_new(), TransferType::Full);
+
+  BOOST_CHECK_EQUAL(timestamper->timestamp(*buffer, 5 * GST_SECOND), 5 * GST_SECOND);
+  BOOST_CHECK_EQUAL(GST_BUFFER_PTS(buffer.get()), 5 * GST_SECOND);
+  BOOST_CHECK(GST_BUFFER_FLAG_IS_SET(buffer.get(), GST_BUFFER_FLAG_DISCONT));
+}
+
+BOOST_FIXTURE_TEST_CASE(JitterIsSmoothed, AppSrcTimestamperTest)
+{
+  auto timestamper = AppSrcTimestamper::create(ElementFactory::makeElement("appsrc"));
+  const GstClockTime interval = 40 * GST_MSECOND;
+  const GstClockTimeDiff jitter[] = {3, -2, 4, -3, 1, -4, 2, 0}; // milliseconds
+
+  GstClockTime lastPts = GST_CLOCK_TIME_NONE;
+  for(int i = 0; i < 200; ++i)
+  {
+    auto buffer = makeGstSharedPtr(gst_buffer_new(), TransferType::Full);
+    const GstClockTime arrival = GST_SECOND + i * interval + jitter[i % 8] * GST_MSECOND;
+    const GstClockTime pts = timestamper->timestamp(*buffer, arrival);
+
+    if(i >= 50)
+    {
+      // after the warm up, the timestamps follow the frame rate instead of the arrival times (up to 7ms jitter)
+      const GstClockTimeDiff delta = GST_CLOCK_DIFF(lastPts, pts);
+      BOOST_CHECK_LT(std::abs(delta - static_cast<GstClockTimeDiff>(interval)), static_cast<GstClockTimeDiff>(2 * GST_MSECOND));
+      BOOST_CHECK_LT(std::abs(static_cast<GstClockTimeDiff>(GST_BUFFER_DURATION(buffer.get()) - interval)), static_cast<GstClockTimeDiff>(2 * GST_MSECOND));
+      BOOST_CHECK(! GST_BUFFER_FLAG_IS_SET(buffer.get(), GST_BUFFER_FLAG_DISCONT));
+    }
+    lastPts = pts;
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(GapCausesDiscontinuity, AppSrcTimestamperTest)
+{
+  auto timestamper = AppSrcTimestamper::create(ElementFactory::makeElement("appsrc"));
+  const GstClockTime interval = 40 * GST_MSECOND;
+
+  GstClockTime arrival = 0;
+  for(int i = 0; i < 20; ++i)
+  {
+    auto buffer = makeGstSharedPtr(gst_buffer_new(), TransferType::Full);
+    arrival = i * interval;
+    timestamper->timestamp(*buffer, arrival);
+  }
+
+  // one lost frame is not a discontinuity
+  arrival += 2 * interval;
+  auto afterLostFrame = makeGstSharedPtr(gst_buffer_new(), TransferType::Full);
+  BOOST_CHECK_EQUAL(timestamper->timestamp(*afterLostFrame, arrival), arrival);
+  BOOST_CHECK(! GST_BUFFER_FLAG_IS_SET(afterLostFrame.get(), GST_BUFFER_FLAG_DISCONT));
+
+  // a pause of the source is
+  arrival += 2 * GST_SECOND;
+  auto afterPause = makeGstSharedPtr(gst_buffer_new(), TransferType::Full);
+  BOOST_CHECK_EQUAL(timestamper->timestamp(*afterPause, arrival), arrival);
+  BOOST_CHECK(GST_BUFFER_FLAG_IS_SET(afterPause.get(), GST_BUFFER_FLAG_DISCONT));
+}
+
+BOOST_FIXTURE_TEST_CASE(NominalDurationIsUsed, AppSrcTimestamperTest)
+{
+  auto timestamper = AppSrcTimestamper::create(ElementFactory::makeElement("appsrc"));
+  timestamper->setNominalDuration(33 * GST_MSECOND);
+
+  auto buffer = makeGstSharedPtr(gst_buffer_new(), TransferType::Full);
+  timestamper->timestamp(*buffer, 0);
+  BOOST_CHECK_EQUAL(GST_BUFFER_DURATION(buffer.get()), 33 * GST_MSECOND);
+}
+
+BOOST_FIXTURE_TEST_CASE(NoRunningTimeWithoutClock, AppSrcTimestamperTest)
+{
+  auto timestamper = AppSrcTimestamper::create(ElementFactory::makeElement("appsrc"));
+  BOOST_CHECK_EQUAL(timestamper->getCurrentRunningTime(), GST_CLOCK_TIME_NONE);
+}
@@ -6,7 +6,10 @@
 
 #include <gst/gst.h>
 
+#include <atomic>
+#include <chrono>
 #include <stdexcept>
+#include <thread>
 
 #include <cstdlib>
 
@@ -154,3 +157,193 @@ BOOST_FIXTURE_TEST_CASE(FromDescriptionInvalidPipelineThrows, BinTest)
     , std::runtime_error);
 }
 
+
+BOOST_FIXTURE_TEST_CASE(ReplaceElementWhilePlaying, BinTest)
+{
+  auto bin = Bin::fromDescription("fakesrc ! identity name=old ! fakesink", false);
+  auto oldElement = bin->getElementByName("old");
+  auto newElement = Element::create(gst_element_factory_make("identity", "new"), TransferType::Floating);
+
+  std::atomic<int> newBuffers{0};
+  g_signal_connect(
+    newElement->getGstElement().get(),
+    "handoff",
+    G_CALLBACK(+[](GstElement*, GstBuffer*, gpointer userData) { ++*static_cast<std::atomic<int>*>(userData); }),
+    &newBuffers
+  );
+
+  bin->setState(GST_STATE_PLAYING);
+  auto future = bin->replaceElement(oldElement, newElement);
+  BOOST_REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  BOOST_CHECK_NO_THROW(future.get());
+
+  BOOST_CHECK_THROW((void)bin->getElementByName("old"), std::runtime_error);
+  BOOST_CHECK_EQUAL(bin->getElementByName("new")->getGstElement(), newElement->getGstElement());
+  BOOST_CHECK_EQUAL(oldElement->getState(), GST_STATE_NULL);
+  BOOST_CHECK_EQUAL(newElement->getState(), GST_STATE_PLAYING);
+
+  // data flows through the replacement
+  for(int i = 0; i < 100 && newBuffers == 0; ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  BOOST_CHECK_GT(newBuffers.load(), 0);
+
+  bin->setState(GST_STATE_NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(ReplaceElementInNullState, BinTest)
+{
+  auto bin = Bin::fromDescription("fakesrc ! identity name=old ! fakesink", false);
+  auto oldElement = bin->getElementByName("old");
+  auto newElement = Element::create(gst_element_factory_make("queue", "new"), TransferType::Floating);
+
+  // nothing to drain, swapped right away
+  auto future = bin->replaceElement(oldElement, newElement);
+  BOOST_REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  BOOST_CHECK_NO_THROW(future.get());
+  BOOST_CHECK_THROW((void)bin->getElementByName("old"), std::runtime_error);
+  BOOST_CHECK(gst_pad_is_linked(makeGstSharedPtr(newElement->getStaticPad("sink"), TransferType::Full).get()));
+  BOOST_CHECK(gst_pad_is_linked(makeGstSharedPtr(newElement->getStaticPad("src"), TransferType::Full).get()));
+}
+
+BOOST_FIXTURE_TEST_CASE(ReplaceElementWithoutDrainAfterTimeout, BinTest)
+{
+  auto bin = Bin::fromDescription("fakesrc is-live=true ! identity name=old ! fakesink", false);
+  auto oldElement = bin->getElementByName("old");
+  auto newElement = Element::create(gst_element_factory_make("identity", "new"), TransferType::Floating);
+
+  // the old element never drains
+  auto oldSrcPad = makeGstSharedPtr(oldElement->getStaticPad("src"), TransferType::Full);
+  gst_pad_add_probe(
+    oldSrcPad.get(),
+    GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+    [](GstPad*, GstPadProbeInfo* info, gpointer) -> GstPadProbeReturn
+    {
+      return GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) == GST_EVENT_EOS ? GST_PAD_PROBE_DROP : GST_PAD_PROBE_OK;
+    },
+    nullptr,
+    nullptr
+  );
+
+  bin->setState(GST_STATE_PLAYING);
+  auto future = bin->replaceElement(oldElement, newElement, 100 * GST_MSECOND);
+  BOOST_REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  BOOST_CHECK_NO_THROW(future.get());
+  BOOST_CHECK_EQUAL(bin->getElementByName("new")->getGstElement(), newElement->getGstElement());
+  BOOST_CHECK_EQUAL(newElement->getState(), GST_STATE_PLAYING);
+
+  bin->setState(GST_STATE_NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(ReplaceElementInvalidArguments, BinTest)
+{
+  auto bin = Bin::fromDescription("fakesrc ! identity name=linked ! fakesink", false);
+  auto linked = bin->getElementByName("linked");
+  auto unlinked = Element::create(gst_element_factory_make("identity", "unlinked"), TransferType::Floating);
+  bin->addElement(unlinked);
+  auto replacement = Element::create(gst_element_factory_make("identity", "replacement"), TransferType::Floating);
+  auto source = Element::create(gst_element_factory_make("fakesrc", "source"), TransferType::Floating);
+
+  BOOST_CHECK_THROW((void)bin->replaceElement(linked, std::shared_ptr<Element>()), std::invalid_argument);
+  BOOST_CHECK_THROW((void)bin->replaceElement(unlinked, replacement), std::invalid_argument);
+  BOOST_CHECK_THROW((void)bin->replaceElement(replacement, linked), std::invalid_argument);
+  BOOST_CHECK_THROW((void)bin->replaceElement(linked, unlinked), std::invalid_argument);
+  BOOST_CHECK_THROW((void)bin->replaceElement(linked, source), std::invalid_argument);
+}
+
+BOOST_FIXTURE_TEST_CASE(NameIndexReturnsCachedElements, BinTest)
+{
+  auto bin = Bin::fromDescription("fakesrc name=src ! identity name=id ! fakesink name=sink", false);
+  BOOST_CHECK(! bin->hasNameIndex());
+  bin->enableNameIndex();
+  BOOST_CHECK(bin->hasNameIndex());
+  BOOST_CHECK_NO_THROW(bin->enableNameIndex());
+
+  // shared by all wrappers of the GstBin
+  BOOST_CHECK(Bin::create(bin->getGstBin())->hasNameIndex());
+
+  auto identity = bin->getElementByName("id");
+  BOOST_CHECK_EQUAL(identity->getName(), "id");
+  BOOST_CHECK_EQUAL(bin->getElementByName("id"), identity);
+  BOOST_CHECK_THROW((void)bin->getElementByName("DoesNotExist"), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(NameIndexFollowsAddAndRemove, BinTest)
+{
+  auto bin = Bin::create("bin1");
+  auto inner = Bin::create("inner");
+  bin->addElement(inner);
+  bin->enableNameIndex();
+
+  auto added = makeGstSharedPtr(gst_element_factory_make("identity", "added"), TransferType::Floating);
+  bin->addElement(added);
+  BOOST_CHECK_EQUAL(bin->getElementByName("added")->getGstElement(), added);
+
+  // nested elements, added after the index was enabled
+  auto deep = makeGstSharedPtr(gst_element_factory_make("identity", "deep"), TransferType::Floating);
+  inner->addElement(deep);
+  BOOST_CHECK_EQUAL(bin->getElementByName("deep")->getGstElement(), deep);
+
+  // a child bin with children
+  auto subBin = Bin::fromDescription("identity name=subChild", false);
+  bin->addElement(subBin);
+  BOOST_CHECK_NO_THROW((void)bin->getElementByName("subChild"));
+
+  bin->removeElement(added);
+  inner->removeElement(deep);
+  bin->removeElement(subBin);
+  BOOST_CHECK_THROW((void)bin->getElementByName("added"), std::runtime_error);
+  BOOST_CHECK_THROW((void)bin->getElementByName("deep"), std::runtime_error);
+  BOOST_CHECK_THROW((void)bin->getElementByName("subChild"), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(NameIndexDuplicateNamesInChildBins, BinTest)
+{
+  auto bin = Bin::create("bin1");
+  auto inner1 = Bin::fromDescription("identity name=twin", false);
+  auto inner2 = Bin::fromDescription("identity name=twin", false);
+  bin->addElement(inner1);
+  bin->addElement(inner2);
+
+  const auto expected = makeGstSharedPtr(gst_bin_get_by_name(bin->getGstBin().get(), "twin"), TransferType::Full);
+  bin->enableNameIndex();
+  BOOST_CHECK_EQUAL(bin->getElementByName("twin")->getGstElement(), expected);
+
+  inner1->removeElement(inner1->getElementByName("twin"));
+  inner2->removeElement(inner2->getElementByName("twin"));
+  BOOST_CHECK_THROW((void)bin->getElementByName("twin"), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(NameIndexRecurseUp, BinTest)
+{
+  auto outer = Bin::fromDescription("identity name=outerChild", false);
+  auto inner = Bin::create("inner");
+  outer->addElement(inner);
+  outer->enableNameIndex();
+
+  BOOST_CHECK_EQUAL(inner->getElementByNameRecurseUp("outerChild"), outer->getElementByName("outerChild"));
+  BOOST_CHECK_THROW((void)inner->getElementByNameRecurseUp("DoesNotExist"), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(ElementRemovedAndDeepSignals, BinTest)
+{
+  auto bin = Bin::create("bin1");
+  auto inner = Bin::create("inner");
+  bin->addElement(inner);
+
+  std::string removed;
+  std::string deepAdded;
+  std::string deepRemoved;
+  bin->elementRemovedSignal().connect([&](GstElementSPtr element){ removed = GST_OBJECT_NAME(element.get()); });
+  bin->deepElementAddedSignal().connect([&](GstBinSPtr, GstElementSPtr element){ deepAdded = GST_OBJECT_NAME(element.get()); });
+  bin->deepElementRemovedSignal().connect([&](GstBinSPtr, GstElementSPtr element){ deepRemoved = GST_OBJECT_NAME(element.get()); });
+
+  auto deep = makeGstSharedPtr(gst_element_factory_make("identity", "deep"), TransferType::Floating);
+  inner->addElement(deep);
+  BOOST_CHECK_EQUAL(deepAdded, "deep");
+  inner->removeElement(deep);
+  BOOST_CHECK_EQUAL(deepRemoved, "deep");
+  bin->removeElement(inner);
+  BOOST_CHECK_EQUAL(removed, "inner");
+}
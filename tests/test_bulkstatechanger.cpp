@@ -0,0 +1,88 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_bulkstatechanger.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-25
+ */
+
+#include "bulkstatechanger.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace dh::gst;
+
+class BulkStateChangerTest
+{
+public:
+  // Setup before first test case
+  BulkStateChangerTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+namespace
+{
+std::vector<std::shared_ptr<Pipeline>> makeTestPipelines(std::size_t count)
+{
+  std::vector<std::shared_ptr<Pipeline>> pipelines;
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    pipelines.push_back(Pipeline::create(Pipeline::fromDescription("fakesrc is-live=true ! fakesink").getGstPipeline()));
+  }
+  return pipelines;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(AllPipelinesReachState, BulkStateChangerTest)
+{
+  auto changer = BulkStateChanger::create(4);
+  BOOST_CHECK_EQUAL(changer->getWorkerCount(), 4u);
+
+  const auto pipelines = makeTestPipelines(20);
+  std::atomic<int> callbacks{0};
+  auto future = changer->setState(pipelines, GST_STATE_PLAYING, 5 * GST_SECOND, [&](const BulkStateChanger::Result&){ ++callbacks; });
+  BOOST_REQUIRE(future.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+  const auto results = future.get();
+  BOOST_REQUIRE_EQUAL(results.size(), pipelines.size());
+  BOOST_CHECK_EQUAL(callbacks.load(), 20);
+  for(std::size_t i = 0; i < results.size(); ++i)
+  {
+    BOOST_CHECK(results[i].pipeline == pipelines[i]);
+    BOOST_CHECK(results[i].result == GST_STATE_CHANGE_SUCCESS || results[i].result == GST_STATE_CHANGE_NO_PREROLL);
+    BOOST_CHECK(GST_CLOCK_TIME_IS_VALID(results[i].duration));
+    BOOST_CHECK_EQUAL(pipelines[i]->getState(), GST_STATE_PLAYING);
+  }
+
+  const auto stopped = changer->setState(pipelines, GST_STATE_NULL).get();
+  for(const auto& result : stopped)
+  {
+    BOOST_CHECK_EQUAL(result.result, GST_STATE_CHANGE_SUCCESS);
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(EmptySetIsReadyImmediately, BulkStateChangerTest)
+{
+  auto changer = BulkStateChanger::create();
+  BOOST_CHECK_GE(changer->getWorkerCount(), 1u);
+  auto future = changer->setState({}, GST_STATE_PLAYING);
+  BOOST_CHECK(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+  BOOST_CHECK(future.get().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(NullPipelineThrows, BulkStateChangerTest)
+{
+  auto changer = BulkStateChanger::create(1);
+  BOOST_CHECK_THROW((void)changer->setState({nullptr}, GST_STATE_PLAYING), std::invalid_argument);
+}
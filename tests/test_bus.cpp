@@ -50,3 +50,45 @@ BOOST_FIXTURE_TEST_CASE(BusReceivesMessageFromPost, BusTest)
   bus->post(mockMessage);
   BOOST_REQUIRE(signalReceived);
 }
+
+BOOST_FIXTURE_TEST_CASE(TimedPopFilteredDropsOtherTypes, BusTest)
+{
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  bus->post(makeGstSharedPtr(gst_message_new_application(nullptr, gst_structure_new_empty("TestMessage")), TransferType::Full));
+  bus->post(makeGstSharedPtr(gst_message_new_eos(nullptr), TransferType::Full));
+
+  auto message = bus->timedPopFiltered(0, GST_MESSAGE_EOS);
+  BOOST_REQUIRE(message);
+  BOOST_CHECK_EQUAL(GST_MESSAGE_TYPE(message.get()), GST_MESSAGE_EOS);
+
+  // the application message was dropped
+  BOOST_CHECK(! bus->timedPopFiltered(0, GST_MESSAGE_ANY));
+}
+
+BOOST_FIXTURE_TEST_CASE(DrainHandlesPendingMessages, BusTest)
+{
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  BOOST_CHECK_GE(bus->getPollFd(), 0);
+  BOOST_CHECK(! bus->pop());
+
+  for(int i = 0; i < 3; ++i)
+  {
+    bus->post(makeGstSharedPtr(gst_message_new_eos(nullptr), TransferType::Full));
+  }
+
+  std::size_t handled{0};
+  const auto handler = [&handled](GstMessageSPtr message)
+  {
+    BOOST_CHECK_EQUAL(GST_MESSAGE_TYPE(message.get()), GST_MESSAGE_EOS);
+    ++handled;
+  };
+
+  // batch limit
+  BOOST_CHECK_EQUAL(bus->drain(handler, 2), 2u);
+  BOOST_CHECK_EQUAL(handled, 2u);
+
+  // rest
+  BOOST_CHECK_EQUAL(bus->drain(handler), 1u);
+  BOOST_CHECK_EQUAL(handled, 3u);
+  BOOST_CHECK_EQUAL(bus->drain(handler), 0u);
+}
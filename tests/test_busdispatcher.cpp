@@ -0,0 +1,207 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_busdispatcher.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-16
+ */
+
+#include "busdispatcher.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace dh::gst;
+
+class BusDispatcherTest
+{
+public:
+  // Setup before first test case
+  BusDispatcherTest()
+  {
+    // Set G_DEBUG to fatal_warnings to make warnings crash the program
+    setenv("G_DEBUG", "fatal_warnings", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(MaskFollowsSubscriptions, BusDispatcherTest)
+{
+  auto dispatcher = BusDispatcher::create(Bus::create(gst_bus_new(), TransferType::Full));
+  BOOST_CHECK_EQUAL(dispatcher->getMessageMask(), GST_MESSAGE_UNKNOWN);
+
+  auto errorConnection = dispatcher->subscribe(GST_MESSAGE_ERROR, [](GstMessageSPtr){});
+  auto eosConnection = dispatcher->subscribe(GST_MESSAGE_EOS, [](GstMessageSPtr){});
+  BOOST_CHECK_EQUAL(dispatcher->getMessageMask(), GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
+
+  errorConnection.disconnect();
+  BOOST_CHECK_EQUAL(dispatcher->getMessageMask(), GST_MESSAGE_EOS);
+}
+
+BOOST_FIXTURE_TEST_CASE(DispatchesSubscribedTypesFromOwnThread, BusDispatcherTest)
+{
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  auto dispatcher = BusDispatcher::create(bus);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<GstMessageType> received;
+  std::thread::id slotThread;
+
+  auto connection = dispatcher->subscribe(
+    GST_MESSAGE_EOS,
+    [&](GstMessageSPtr message)
+    {
+      std::lock_guard lock(mutex);
+      received.push_back(GST_MESSAGE_TYPE(message.get()));
+      slotThread = std::this_thread::get_id();
+      condition.notify_all();
+    }
+  );
+  dispatcher->start();
+  BOOST_CHECK(dispatcher->isRunning());
+
+  // not subscribed, must be dropped
+  bus->post(makeGstSharedPtr(gst_message_new_application(nullptr, gst_structure_new_empty("Test")), TransferType::Full));
+  bus->post(makeGstSharedPtr(gst_message_new_eos(nullptr), TransferType::Full));
+
+  std::unique_lock lock(mutex);
+  BOOST_REQUIRE(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return ! received.empty(); }));
+  BOOST_CHECK_EQUAL(received.size(), 1u);
+  BOOST_CHECK_EQUAL(received.front(), GST_MESSAGE_EOS);
+  BOOST_CHECK(slotThread != std::this_thread::get_id());
+  lock.unlock();
+
+  dispatcher->stop();
+  BOOST_CHECK(! dispatcher->isRunning());
+}
+
+BOOST_FIXTURE_TEST_CASE(DispatchesToMessageParser, BusDispatcherTest)
+{
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  auto dispatcher = BusDispatcher::create(bus);
+  auto parser = MessageParser::create();
+
+  auto connection = dispatcher->subscribe(parser);
+  BOOST_CHECK_EQUAL(dispatcher->getMessageMask(), GST_MESSAGE_UNKNOWN);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool endOfStream = false;
+  parser->endOfStreamRecordSignal.connect(
+    [&](const MessageRecord&)
+    {
+      std::lock_guard lock(mutex);
+      endOfStream = true;
+      condition.notify_all();
+    }
+  );
+  BOOST_CHECK_EQUAL(dispatcher->getMessageMask(), GST_MESSAGE_EOS);
+
+  dispatcher->start();
+  bus->post(makeGstSharedPtr(gst_message_new_eos(nullptr), TransferType::Full));
+
+  std::unique_lock lock(mutex);
+  BOOST_CHECK(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return endOfStream; }));
+  lock.unlock();
+  dispatcher->stop();
+
+  // the dispatcher does not keep the parser alive
+  parser.reset();
+  BOOST_CHECK_EQUAL(dispatcher->getMessageMask(), GST_MESSAGE_UNKNOWN);
+}
+
+BOOST_FIXTURE_TEST_CASE(StopsWhileBusIsFlushing, BusDispatcherTest)
+{
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  auto dispatcher = BusDispatcher::create(bus);
+  dispatcher->start();
+
+  // a pipeline in NULL state flushes its bus, posted wake ups are dropped then
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  gst_bus_set_flushing(bus->getGstBus().get(), TRUE);
+  dispatcher->stop();
+  BOOST_CHECK(! dispatcher->isRunning());
+  BOOST_CHECK(GST_OBJECT_FLAG_IS_SET(bus->getGstBus().get(), GST_BUS_FLUSHING));
+}
+
+BOOST_FIXTURE_TEST_CASE(ExtendedTypesDoNotMatchBasicTypes, BusDispatcherTest)
+{
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  auto dispatcher = BusDispatcher::create(bus);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<GstMessageType> received;
+  auto connection = dispatcher->subscribe(
+    GST_MESSAGE_EOS,
+    [&](GstMessageSPtr message)
+    {
+      std::lock_guard lock(mutex);
+      received.push_back(GST_MESSAGE_TYPE(message.get()));
+      condition.notify_all();
+    }
+  );
+  dispatcher->start();
+
+  // GST_MESSAGE_STREAMS_SELECTED contains the bit of GST_MESSAGE_EOS
+  GstStreamCollection* collection = gst_stream_collection_new(nullptr);
+  bus->post(makeGstSharedPtr(gst_message_new_streams_selected(nullptr, collection), TransferType::Full));
+  gst_object_unref(collection);
+  bus->post(makeGstSharedPtr(gst_message_new_eos(nullptr), TransferType::Full));
+
+  std::unique_lock lock(mutex);
+  BOOST_REQUIRE(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return ! received.empty(); }));
+  BOOST_CHECK_EQUAL(received.size(), 1u);
+  BOOST_CHECK_EQUAL(received.front(), GST_MESSAGE_EOS);
+  lock.unlock();
+  dispatcher->stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(MaskChangesWhileRunning, BusDispatcherTest)
+{
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  auto dispatcher = BusDispatcher::create(bus);
+  auto parser = MessageParser::create();
+  auto parserConnection = dispatcher->subscribe(parser);
+  dispatcher->start();
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool error = false;
+  bool endOfStream = false;
+  // both are connected while the thread waits with the empty mask
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto errorConnection = dispatcher->subscribe(
+    GST_MESSAGE_ERROR,
+    [&](GstMessageSPtr)
+    {
+      std::lock_guard lock(mutex);
+      error = true;
+      condition.notify_all();
+    }
+  );
+  parser->endOfStreamRecordSignal.connect(
+    [&](const MessageRecord&)
+    {
+      std::lock_guard lock(mutex);
+      endOfStream = true;
+      condition.notify_all();
+    }
+  );
+
+  GError* gerror = g_error_new_literal(GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "test");
+  bus->post(makeGstSharedPtr(gst_message_new_error(nullptr, gerror, nullptr), TransferType::Full));
+  g_error_free(gerror);
+  bus->post(makeGstSharedPtr(gst_message_new_eos(nullptr), TransferType::Full));
+
+  std::unique_lock lock(mutex);
+  BOOST_CHECK(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return error && endOfStream; }));
+  lock.unlock();
+  dispatcher->stop();
+}
@@ -0,0 +1,137 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_bushub.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-25
+ */
+
+#include "bushub.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace dh::gst;
+
+class BusHubTest
+{
+public:
+  // Setup before first test case
+  BusHubTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+namespace
+{
+GstMessageSPtr makeApplicationMessage()
+{
+  return makeGstSharedPtr(gst_message_new_application(nullptr, gst_structure_new_empty("Test")), TransferType::Full);
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(RejectsInvalidArguments, BusHubTest)
+{
+  BOOST_CHECK_THROW((void)BusHub::create(0), std::invalid_argument);
+  auto hub = BusHub::create(1);
+  BOOST_CHECK_THROW(hub->add(*Pipeline::create("pipeline"), nullptr), std::invalid_argument);
+  BOOST_CHECK_THROW(hub->setBatchSize(0), std::invalid_argument);
+  BOOST_CHECK(! hub->remove(42));
+}
+
+BOOST_FIXTURE_TEST_CASE(ServicesManyPipelines, BusHubTest)
+{
+  auto hub = BusHub::create(2);
+  std::mutex mutex;
+  std::condition_variable condition;
+  int handled = 0;
+
+  std::vector<std::shared_ptr<Pipeline>> pipelines;
+  for(int i = 0; i < 10; ++i)
+  {
+    pipelines.push_back(Pipeline::create("pipeline" + std::to_string(i)));
+    hub->add(
+      *pipelines.back(),
+      [&](GstMessageSPtr)
+      {
+        std::lock_guard lock(mutex);
+        ++handled;
+        condition.notify_all();
+      }
+    );
+  }
+  BOOST_CHECK_EQUAL(hub->getPipelineCount(), 10u);
+
+  for(const auto& pipeline : pipelines)
+  {
+    for(int i = 0; i < 5; ++i)
+    {
+      pipeline->getBus()->post(makeApplicationMessage());
+    }
+  }
+
+  std::unique_lock lock(mutex);
+  BOOST_CHECK(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return handled == 50; }));
+}
+
+BOOST_FIXTURE_TEST_CASE(PriorityMessagesFirstAndQueueLimit, BusHubTest)
+{
+  auto hub = BusHub::create(1);
+  hub->setQueueLimit(2);
+  auto pipeline = Pipeline::create("pipeline");
+
+  std::promise<void> started;
+  std::promise<void> gate;
+  auto gateFuture = gate.get_future().share();
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<GstMessageType> handled;
+
+  hub->add(
+    *pipeline,
+    [&, first = true](GstMessageSPtr message) mutable
+    {
+      if(first)
+      {
+        first = false;
+        started.set_value();
+        gateFuture.wait();
+      }
+      std::lock_guard lock(mutex);
+      handled.push_back(GST_MESSAGE_TYPE(message.get()));
+      condition.notify_all();
+    }
+  );
+
+  auto bus = pipeline->getBus();
+  bus->post(makeApplicationMessage());
+  BOOST_REQUIRE(started.get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+
+  // the worker is blocked: 2 are queued, 2 are dropped, EOS is never dropped
+  for(int i = 0; i < 4; ++i)
+  {
+    bus->post(makeApplicationMessage());
+  }
+  bus->post(makeGstSharedPtr(gst_message_new_eos(nullptr), TransferType::Full));
+  BOOST_CHECK_EQUAL(hub->getDroppedCount(), 2u);
+  gate.set_value();
+
+  std::unique_lock lock(mutex);
+  BOOST_REQUIRE(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return handled.size() == 4; }));
+  BOOST_CHECK_EQUAL(handled[0], GST_MESSAGE_APPLICATION);
+  BOOST_CHECK_EQUAL(handled[1], GST_MESSAGE_EOS);
+  BOOST_CHECK_EQUAL(handled[2], GST_MESSAGE_APPLICATION);
+  BOOST_CHECK_EQUAL(handled[3], GST_MESSAGE_APPLICATION);
+}
@@ -0,0 +1,165 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_busmetrics.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-24
+ */
+
+#include "busmetrics.hpp"
+#include "messageparser.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dh::gst;
+
+class BusMetricsTest
+{
+public:
+  // Setup before first test case
+  BusMetricsTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(CountsPerTypeAndSource, BusMetricsTest)
+{
+  auto metrics = BusMetrics::create();
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  auto connection = metrics->attach(bus);
+
+  GstElement* element = gst_element_factory_make("fakesrc", "counted_source");
+  bus->post(makeGstSharedPtr(gst_message_new_eos(GST_OBJECT(element)), TransferType::Full));
+  bus->post(makeGstSharedPtr(gst_message_new_eos(GST_OBJECT(element)), TransferType::Full));
+  bus->post(makeGstSharedPtr(gst_message_new_latency(nullptr), TransferType::Full));
+
+  BOOST_CHECK_EQUAL(metrics->getMessageCount(GST_MESSAGE_EOS), 2u);
+  BOOST_CHECK_EQUAL(metrics->getMessageCount(GST_MESSAGE_LATENCY), 1u);
+  BOOST_CHECK_EQUAL(metrics->getMessageCount(GST_MESSAGE_ERROR), 0u);
+  BOOST_CHECK_EQUAL(metrics->getTotalMessageCount(), 3u);
+
+  bool sourceFound = false;
+  for(const auto& [source, count] : metrics->getSourceCounts())
+  {
+    if(source == g_quark_from_string("counted_source"))
+    {
+      sourceFound = true;
+      BOOST_CHECK_EQUAL(count, 2u);
+    }
+  }
+  BOOST_CHECK(sourceFound);
+
+  metrics->reset();
+  BOOST_CHECK_EQUAL(metrics->getTotalMessageCount(), 0u);
+  gst_object_unref(element);
+}
+
+BOOST_FIXTURE_TEST_CASE(ExtendedTypesHaveOwnCounter, BusMetricsTest)
+{
+  auto metrics = BusMetrics::create();
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  auto connection = metrics->attach(bus);
+
+  // GST_MESSAGE_STREAMS_SELECTED contains the bit of GST_MESSAGE_EOS
+  GstStreamCollection* collection = gst_stream_collection_new(nullptr);
+  bus->post(makeGstSharedPtr(gst_message_new_streams_selected(nullptr, collection), TransferType::Full));
+  gst_object_unref(collection);
+  bus->post(makeGstSharedPtr(gst_message_new_eos(nullptr), TransferType::Full));
+
+  BOOST_CHECK_EQUAL(metrics->getMessageCount(GST_MESSAGE_EOS), 1u);
+  BOOST_CHECK_EQUAL(metrics->getMessageCount(GST_MESSAGE_ERROR), 0u);
+  BOOST_CHECK_EQUAL(metrics->getMessageCount(GST_MESSAGE_STREAMS_SELECTED), 1u);
+  BOOST_CHECK_EQUAL(metrics->getTotalMessageCount(), 2u);
+}
+
+BOOST_FIXTURE_TEST_CASE(SlowHandlersAreReported, BusMetricsTest)
+{
+  auto metrics = BusMetrics::create();
+  metrics->setLatencyBudget(GST_MSECOND);
+
+  std::string slowHandler;
+  metrics->slowHandlerSignal.connect(
+    [&slowHandler](std::string_view handlerName, GstMessageType, GstClockTime)
+    {
+      slowHandler = handlerName;
+    }
+  );
+
+  auto fastSlot = metrics->instrument("fast", [](GstMessageSPtr){});
+  auto slowSlot = metrics->instrument("slow", [](GstMessageSPtr){ std::this_thread::sleep_for(std::chrono::milliseconds(5)); });
+
+  const auto message = makeGstSharedPtr(gst_message_new_eos(nullptr), TransferType::Full);
+  fastSlot(message);
+  BOOST_CHECK_EQUAL(metrics->getSlowHandlerCount(), 0u);
+  slowSlot(message);
+  BOOST_CHECK_EQUAL(metrics->getSlowHandlerCount(), 1u);
+  BOOST_CHECK_EQUAL(slowHandler, "slow");
+
+  const auto histogram = metrics->getHandlerHistogram();
+  BOOST_CHECK_EQUAL(std::accumulate(histogram.begin(), histogram.end(), std::uint64_t{0}), 2u);
+}
+
+BOOST_FIXTURE_TEST_CASE(MeasuresMessageParser, BusMetricsTest)
+{
+  auto metrics = BusMetrics::create();
+  auto parser = MessageParser::create();
+  parser->setMetrics(metrics);
+  parser->endOfStreamSignal.connect([](const std::string&){});
+
+  GstMessage* message = gst_message_new_eos(nullptr);
+  parser->parse(*message);
+  gst_message_unref(message);
+  // not observed by the parser, but counted
+  message = gst_message_new_latency(nullptr);
+  parser->parse(*message);
+  gst_message_unref(message);
+
+  BOOST_CHECK_EQUAL(metrics->getTotalMessageCount(), 2u);
+  const auto histogram = metrics->getHandlerHistogram();
+  BOOST_CHECK_EQUAL(std::accumulate(histogram.begin(), histogram.end(), std::uint64_t{0}), 1u);
+}
+
+BOOST_FIXTURE_TEST_CASE(MeasuresEachParserSlot, BusMetricsTest)
+{
+  auto metrics = BusMetrics::create();
+  metrics->setLatencyBudget(5 * GST_MSECOND);
+  auto parser = MessageParser::create();
+  parser->setMetrics(metrics);
+
+  std::vector<std::string> slowHandlers;
+  metrics->slowHandlerSignal.connect(
+    [&](std::string_view handlerName, GstMessageType, GstClockTime)
+    {
+      slowHandlers.emplace_back(handlerName);
+    }
+  );
+  parser->endOfStreamSignal.connect([](const std::string&){});
+  parser->endOfStreamRecordSignal.connectNamed(
+    "slow",
+    [](const MessageRecord&)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  );
+
+  GstMessage* message = gst_message_new_eos(nullptr);
+  parser->parse(*message);
+  gst_message_unref(message);
+
+  const auto histogram = metrics->getHandlerHistogram();
+  BOOST_CHECK_EQUAL(std::accumulate(histogram.begin(), histogram.end(), std::uint64_t{0}), 2u);
+  BOOST_REQUIRE_EQUAL(slowHandlers.size(), 1u);
+  BOOST_CHECK_EQUAL(slowHandlers.front(), "slow");
+}
@@ -0,0 +1,106 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_clockgroup.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-27
+ */
+
+#include "clockgroup.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+using namespace dh::gst;
+
+class ClockGroupTest
+{
+public:
+  // Setup before first test case
+  ClockGroupTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+namespace
+{
+std::shared_ptr<Pipeline> makeTestPipeline()
+{
+  return Pipeline::create(Pipeline::fromDescription("videotestsrc is-live=true ! fakesink sync=true").getGstPipeline());
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(PipelinesShareClockAndBaseTime, ClockGroupTest)
+{
+  auto group = ClockGroup::create();
+  auto first = makeTestPipeline();
+  auto second = makeTestPipeline();
+  group->add(first);
+  group->add(second);
+  BOOST_CHECK_EQUAL(group->getPipelineCount(), 2u);
+  BOOST_CHECK_EQUAL(group->getBaseTime(), GST_CLOCK_TIME_NONE);
+
+  const GstClockTime baseTime = group->startTogether();
+  BOOST_CHECK_EQUAL(group->getBaseTime(), baseTime);
+  BOOST_REQUIRE(first->getState(5 * GST_SECOND).result != GST_STATE_CHANGE_FAILURE);
+  BOOST_REQUIRE(second->getState(5 * GST_SECOND).result != GST_STATE_CHANGE_FAILURE);
+
+  for(const auto& pipeline : {first, second})
+  {
+    auto* element = GST_ELEMENT_CAST(pipeline->getGstPipeline().get());
+    BOOST_CHECK_EQUAL(gst_element_get_base_time(element), baseTime);
+    BOOST_CHECK(pipeline->getPipelineClock() == group->getClock());
+  }
+
+  // pausing does not change the base time
+  first->setState(GST_STATE_PAUSED);
+  first->setState(GST_STATE_PLAYING);
+  BOOST_REQUIRE(first->getState(5 * GST_SECOND).result != GST_STATE_CHANGE_FAILURE);
+  BOOST_CHECK_EQUAL(gst_element_get_base_time(GST_ELEMENT_CAST(first->getGstPipeline().get())), baseTime);
+
+  first->setState(GST_STATE_NULL);
+  second->setState(GST_STATE_NULL);
+  second.reset();
+  BOOST_CHECK_EQUAL(group->getPipelineCount(), 1u);
+  group->remove(first);
+  BOOST_CHECK_EQUAL(group->getPipelineCount(), 0u);
+}
+
+BOOST_FIXTURE_TEST_CASE(NetClientFollowsTimeProvider, ClockGroupTest)
+{
+  auto server = ClockGroup::create();
+  const int port = server->startTimeProvider();
+  BOOST_REQUIRE_GT(port, 0);
+
+  auto client = ClockGroup::createNetClient("127.0.0.1", port);
+  BOOST_REQUIRE(client->waitForSync(10 * GST_SECOND));
+
+  const auto stats = client->getClockStats();
+  BOOST_CHECK(stats.synced);
+  // both follow the system clock of this host
+  BOOST_CHECK_LT(std::abs(stats.offset), static_cast<GstClockTimeDiff>(10 * GST_MSECOND));
+
+  // the drift is measured from the sync, not from the creation of the unsynced clock
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  BOOST_CHECK_LT(std::abs(client->getClockStats().driftPpm), 1000.0);
+
+  server->stopTimeProvider();
+}
+
+BOOST_FIXTURE_TEST_CASE(LocalClockHasNoDrift, ClockGroupTest)
+{
+  auto group = ClockGroup::create();
+  const auto stats = group->getClockStats();
+  BOOST_CHECK(stats.synced);
+  BOOST_CHECK_CLOSE(stats.rate, 1.0, 0.001);
+  BOOST_CHECK_LT(std::abs(stats.driftPpm), 1.0);
+}
@@ -1,10 +1,12 @@
 /* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*-  */
 #include "element.hpp"
+#include "pipeline.hpp"
 
 #define BOOST_TEST_MODULE libdhgst_tests
 #include <boost/test/included/unit_test.hpp>
 #include <gst/gst.h>
 
+#include <chrono>
 #include <stdexcept>
 
 #include <cstdlib>
@@ -146,3 +148,69 @@ BOOST_FIXTURE_TEST_CASE(SetName, ElementTest)
   BOOST_CHECK_EQUAL(element->getName(), "secondName");
 }
 
+
+BOOST_FIXTURE_TEST_CASE(SetStateAsyncCompletes, ElementTest)
+{
+  auto pipeline = Pipeline::create(
+    GST_PIPELINE(gst_parse_launch("fakesrc is-live=false ! fakesink", nullptr)),
+    TransferType::Floating
+  );
+
+  auto future = pipeline->setStateAsync(GST_STATE_PAUSED, 5 * GST_SECOND);
+  BOOST_REQUIRE(future.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  BOOST_CHECK_EQUAL(future.get(), GST_STATE_CHANGE_SUCCESS);
+  BOOST_CHECK_EQUAL(pipeline->getState(), GST_STATE_PAUSED);
+
+  // synchronous state changes are completed from the calling thread
+  bool callbackCalled = false;
+  pipeline->setStateAsync(
+    GST_STATE_NULL,
+    [&callbackCalled](GstStateChangeReturn result)
+    {
+      callbackCalled = true;
+      BOOST_CHECK_EQUAL(result, GST_STATE_CHANGE_SUCCESS);
+    }
+  );
+  BOOST_CHECK(callbackCalled);
+}
+
+BOOST_FIXTURE_TEST_CASE(SetStateAsyncTimesOut, ElementTest)
+{
+  // appsrc without data never prerolls
+  auto pipeline = Pipeline::create(
+    GST_PIPELINE(gst_parse_launch("appsrc ! fakesink", nullptr)),
+    TransferType::Floating
+  );
+  auto future = pipeline->setStateAsync(GST_STATE_PAUSED, 100 * GST_MSECOND);
+  BOOST_REQUIRE(future.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  BOOST_CHECK_EQUAL(future.get(), GST_STATE_CHANGE_ASYNC);
+  pipeline->setState(GST_STATE_NULL);
+
+  // without bus, the thread pool waits
+  auto sink = Element::create(gst_element_factory_make("fakesink", nullptr), TransferType::Floating);
+  future = sink->setStateAsync(GST_STATE_PAUSED, 100 * GST_MSECOND);
+  BOOST_REQUIRE(future.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  BOOST_CHECK_EQUAL(future.get(), GST_STATE_CHANGE_ASYNC);
+  sink->setState(GST_STATE_NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(GetStateWithTimeout, ElementTest)
+{
+  auto pipeline = Pipeline::create(
+    GST_PIPELINE(gst_parse_launch("appsrc ! fakesink", nullptr)),
+    TransferType::Floating
+  );
+  auto info = pipeline->getState(0);
+  BOOST_CHECK_EQUAL(info.result, GST_STATE_CHANGE_SUCCESS);
+  BOOST_CHECK_EQUAL(info.current, GST_STATE_NULL);
+  BOOST_CHECK_EQUAL(info.pending, GST_STATE_VOID_PENDING);
+
+  // appsrc without data never prerolls, so the state change stays ASYNC
+  BOOST_CHECK_EQUAL(pipeline->setState(GST_STATE_PAUSED), GST_STATE_CHANGE_ASYNC);
+  info = pipeline->getState(10 * GST_MSECOND);
+  BOOST_CHECK_EQUAL(info.result, GST_STATE_CHANGE_ASYNC);
+  BOOST_CHECK_EQUAL(info.current, GST_STATE_READY);
+  BOOST_CHECK_EQUAL(info.pending, GST_STATE_PAUSED);
+
+  pipeline->setState(GST_STATE_NULL);
+}
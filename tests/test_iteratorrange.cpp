@@ -0,0 +1,131 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_iteratorrange.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-29
+ */
+
+#include "bin.hpp"
+#include "iteratorrange.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace dh::gst;
+
+class IteratorRangeTest
+{
+public:
+  // Setup before first test case
+  IteratorRangeTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+
+  template<typename Range>
+  static std::set<std::string> names(Range&& range)
+  {
+    std::set<std::string> result;
+    for(const auto& object : range)
+    {
+      result.insert(GST_OBJECT_NAME(object.get()));
+    }
+    return result;
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(ObjectRefCounting, IteratorRangeTest)
+{
+  GstElement* raw = gst_element_factory_make("identity", "id");
+  {
+    ObjectRef<GstElement> ref(raw, TransferType::Floating);
+    BOOST_CHECK_EQUAL(GST_OBJECT_REFCOUNT(raw), 1);
+    BOOST_CHECK(! g_object_is_floating(raw));
+
+    ObjectRef<GstElement> copy = ref;
+    BOOST_CHECK_EQUAL(GST_OBJECT_REFCOUNT(raw), 2);
+    BOOST_CHECK(copy == ref);
+
+    ObjectRef<GstElement> moved = std::move(copy);
+    BOOST_CHECK_EQUAL(GST_OBJECT_REFCOUNT(raw), 2);
+    BOOST_CHECK(! copy);
+
+    auto shared = moved.toSharedPtr();
+    BOOST_CHECK_EQUAL(GST_OBJECT_REFCOUNT(raw), 3);
+    gst_object_ref(raw); // keep alive to check the count below
+  }
+  BOOST_CHECK_EQUAL(GST_OBJECT_REFCOUNT(raw), 1);
+  gst_object_unref(raw);
+}
+
+BOOST_FIXTURE_TEST_CASE(IterateBinChildren, IteratorRangeTest)
+{
+  auto bin = Bin::fromDescription("fakesrc name=src ! identity name=id ! fakesink name=sink ( name=inner identity name=deep )", false);
+
+  BOOST_CHECK((names(bin->iterateElements()) == std::set<std::string>{"src", "id", "inner", "sink"}));
+  BOOST_CHECK((names(bin->iterateRecurse()) == std::set<std::string>{"src", "id", "inner", "deep", "sink"}));
+  BOOST_CHECK((names(bin->iterateSinks()) == std::set<std::string>{"sink"}));
+  BOOST_CHECK((names(bin->iterateSources()) == std::set<std::string>{"src"}));
+
+  // sorted: downstream elements first
+  std::vector<std::string> sorted;
+  for(const auto& element : bin->iterateSorted())
+  {
+    sorted.emplace_back(GST_OBJECT_NAME(element.get()));
+  }
+  const auto position = [&sorted](const std::string& name)
+  {
+    return std::find(sorted.begin(), sorted.end(), name) - sorted.begin();
+  };
+  BOOST_CHECK_EQUAL(sorted.size(), 4u);
+  BOOST_CHECK_LT(position("sink"), position("id"));
+  BOOST_CHECK_LT(position("id"), position("src"));
+}
+
+BOOST_FIXTURE_TEST_CASE(IteratePads, IteratorRangeTest)
+{
+  auto bin = Bin::fromDescription("fakesrc ! identity name=id ! fakesink", false);
+  auto identity = bin->getElementByName("id");
+
+  BOOST_CHECK((names(identity->iteratePads()) == std::set<std::string>{"sink", "src"}));
+  BOOST_CHECK((names(identity->iterateSinkPads()) == std::set<std::string>{"sink"}));
+  BOOST_CHECK((names(identity->iterateSrcPads()) == std::set<std::string>{"src"}));
+}
+
+BOOST_FIXTURE_TEST_CASE(EmptyRange, IteratorRangeTest)
+{
+  auto bin = Bin::create("empty");
+  auto range = bin->iterateElements();
+  BOOST_CHECK(range.begin() == range.end());
+
+  ElementRange nullRange(nullptr);
+  BOOST_CHECK(nullRange.begin() == nullRange.end());
+}
+
+BOOST_FIXTURE_TEST_CASE(ResyncRestartsIteration, IteratorRangeTest)
+{
+  auto bin = Bin::fromDescription("fakesrc ! fakesink", false);
+  auto range = bin->iterateElements();
+
+  unsigned visits = 0;
+  for(const auto& element : range)
+  {
+    BOOST_CHECK(element);
+    if(visits++ == 0)
+    {
+      bin->addElement(makeGstSharedPtr(gst_element_factory_make("identity", "added"), TransferType::Floating));
+    }
+  }
+  BOOST_CHECK_EQUAL(range.getResyncCount(), 1u);
+  BOOST_CHECK_EQUAL(visits, 1u + 3u);
+}
@@ -0,0 +1,91 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_messageflightrecorder.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-23
+ */
+
+#include "messageflightrecorder.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace dh::gst;
+
+class MessageFlightRecorderTest
+{
+public:
+  // Setup before first test case
+  MessageFlightRecorderTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(CapacityIsRoundedUp, MessageFlightRecorderTest)
+{
+  BOOST_CHECK_THROW((void)MessageFlightRecorder::create(0), std::invalid_argument);
+  BOOST_CHECK_EQUAL(MessageFlightRecorder::create(3)->getCapacity(), 4u);
+  BOOST_CHECK_EQUAL(MessageFlightRecorder::create(4096)->getCapacity(), 4096u);
+}
+
+BOOST_FIXTURE_TEST_CASE(KeepsTheLastMessages, MessageFlightRecorderTest)
+{
+  auto recorder = MessageFlightRecorder::create(4);
+  GstElement* element = gst_element_factory_make("fakesrc", "recorded_source");
+
+  for(int i = 0; i < 5; ++i)
+  {
+    GstMessage* message = gst_message_new_eos(GST_OBJECT(element));
+    recorder->record(*message);
+    gst_message_unref(message);
+  }
+  GstMessage* message = gst_message_new_state_changed(GST_OBJECT(element), GST_STATE_READY, GST_STATE_PAUSED, GST_STATE_PLAYING);
+  recorder->record(*message);
+  gst_message_unref(message);
+
+  BOOST_CHECK_EQUAL(recorder->getRecordedCount(), 6u);
+  const auto entries = recorder->snapshot();
+  BOOST_REQUIRE_EQUAL(entries.size(), 4u);
+  BOOST_CHECK_EQUAL(entries.front().index, 2u);
+  BOOST_CHECK_EQUAL(entries.front().type, GST_MESSAGE_EOS);
+  BOOST_CHECK_EQUAL(std::string(g_quark_to_string(entries.front().source)), "recorded_source");
+
+  const auto& stateChanged = entries.back();
+  BOOST_CHECK_EQUAL(stateChanged.index, 5u);
+  BOOST_CHECK_EQUAL(stateChanged.type, GST_MESSAGE_STATE_CHANGED);
+  BOOST_CHECK_EQUAL(stateChanged.payload[0], GST_STATE_READY | GST_STATE_PAUSED << 8 | GST_STATE_PLAYING << 16);
+
+  std::ostringstream dump;
+  recorder->dump(dump);
+  BOOST_CHECK(dump.str().find("READY -> PAUSED") != std::string::npos);
+
+  gst_object_unref(element);
+}
+
+BOOST_FIXTURE_TEST_CASE(RecordsAttachedBus, MessageFlightRecorderTest)
+{
+  auto recorder = MessageFlightRecorder::create();
+  auto bus = Bus::create(gst_bus_new(), TransferType::Full);
+  recorder->attach(bus);
+
+  GError* error = g_error_new_literal(GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "Test error");
+  bus->post(makeGstSharedPtr(gst_message_new_error(nullptr, error, nullptr), TransferType::Full));
+  g_error_free(error);
+
+  const auto entries = recorder->snapshot();
+  BOOST_REQUIRE_EQUAL(entries.size(), 1u);
+  BOOST_CHECK_EQUAL(entries.front().type, GST_MESSAGE_ERROR);
+  BOOST_CHECK_EQUAL(entries.front().source, 0u);
+  BOOST_CHECK_EQUAL(entries.front().payload[0], GST_CORE_ERROR);
+  BOOST_CHECK_EQUAL(entries.front().payload[1], static_cast<std::uint64_t>(GST_CORE_ERROR_FAILED));
+}
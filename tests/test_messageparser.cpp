@@ -10,6 +10,9 @@
 #define BOOST_TEST_MODULE libdhgst_tests
 #include <boost/test/included/unit_test.hpp>
 
+#include <functional>
+#include <vector>
+
 using namespace dh::gst;
 
 
@@ -228,3 +231,263 @@ BOOST_FIXTURE_TEST_CASE(AsyncDoneSignalEmittedWithRunningTime, MessageParserTest
   gst_message_unref(message);
   gst_object_unref(element);
 }
+
+BOOST_FIXTURE_TEST_CASE(ErrorRecordSignalEmitted, MessageParserTest)
+{
+  auto parser = MessageParser::create();
+  bool signalCalled = false;
+  std::string receivedText;
+  std::string receivedDebugInfo;
+  GQuark receivedDomain = 0;
+  gint receivedCode = 0;
+
+  parser->errorRecordSignal.connect(
+    [&](const TextMessageRecord& record)
+    {
+      signalCalled = true;
+      BOOST_CHECK_EQUAL(record.sourceName, "unknown");
+      BOOST_CHECK_EQUAL(GST_MESSAGE_TYPE(&record.message), GST_MESSAGE_ERROR);
+      receivedText = record.text;
+      receivedDebugInfo = record.debugInfo;
+      receivedDomain = record.domain;
+      receivedCode = record.code;
+    }
+  );
+
+  GError* error = g_error_new_literal(GST_STREAM_ERROR, GST_STREAM_ERROR_DECODE, "Test error message");
+  GstMessage* message = gst_message_new_error(nullptr, error, nullptr);
+  parser->parse(*message);
+
+  BOOST_CHECK(signalCalled);
+  BOOST_CHECK_EQUAL(receivedText, "Test error message");
+  BOOST_CHECK(receivedDebugInfo.empty());
+  BOOST_CHECK_EQUAL(receivedDomain, GST_STREAM_ERROR);
+  BOOST_CHECK_EQUAL(receivedCode, GST_STREAM_ERROR_DECODE);
+
+  gst_message_unref(message);
+  g_error_free(error);
+}
+
+BOOST_FIXTURE_TEST_CASE(StateChangedRecordReferencesMessage, MessageParserTest)
+{
+  auto parser = MessageParser::create();
+  bool signalCalled = false;
+
+  GstElement* element = gst_element_factory_make("fakesrc", "test_source");
+  GstMessage* message = gst_message_new_state_changed(GST_OBJECT(element), GST_STATE_READY, GST_STATE_PAUSED, GST_STATE_PLAYING);
+
+  parser->stateChangedRecordSignal.connect(
+    [&](const StateChangedRecord& record)
+    {
+      signalCalled = true;
+      BOOST_CHECK_EQUAL(&record.message, message);
+      // no copy of the name
+      BOOST_CHECK_EQUAL(static_cast<const void*>(record.sourceName.data()), static_cast<const void*>(GST_OBJECT_NAME(element)));
+      BOOST_CHECK_EQUAL(record.oldState, GST_STATE_READY);
+      BOOST_CHECK_EQUAL(record.newState, GST_STATE_PAUSED);
+      BOOST_CHECK_EQUAL(record.pendingState, GST_STATE_PLAYING);
+    }
+  );
+  parser->parse(*message);
+
+  BOOST_CHECK(signalCalled);
+
+  gst_message_unref(message);
+  gst_object_unref(element);
+}
+
+BOOST_FIXTURE_TEST_CASE(InterestMaskFollowsConnectedSlots, MessageParserTest)
+{
+  auto parser = MessageParser::create();
+  BOOST_CHECK_EQUAL(parser->getInterestMask(), GST_MESSAGE_UNKNOWN);
+
+  auto errorConnection = parser->errorSignal.connect([](const std::string&, const std::string&, const std::string&){});
+  auto stateConnection = parser->stateChangedRecordSignal.connect([](const StateChangedRecord&){});
+  BOOST_CHECK_EQUAL(parser->getInterestMask(), GST_MESSAGE_ERROR | GST_MESSAGE_STATE_CHANGED);
+
+  errorConnection.disconnect();
+  BOOST_CHECK_EQUAL(parser->getInterestMask(), GST_MESSAGE_STATE_CHANGED);
+}
+
+BOOST_FIXTURE_TEST_CASE(InterestMaskCountsSlotsPerType, MessageParserTest)
+{
+  auto parser = MessageParser::create();
+  auto recordConnection = parser->errorRecordSignal.connect(1, [](const TextMessageRecord&){});
+  auto textConnection = parser->errorSignal.connect([](const std::string&, const std::string&, const std::string&){});
+  BOOST_CHECK_EQUAL(parser->getInterestMask(), GST_MESSAGE_ERROR);
+
+  // still observed by the other signal of the type
+  recordConnection.disconnect();
+  BOOST_CHECK_EQUAL(parser->getInterestMask(), GST_MESSAGE_ERROR);
+
+  parser->errorSignal.disconnect_all_slots();
+  BOOST_CHECK_EQUAL(parser->getInterestMask(), GST_MESSAGE_UNKNOWN);
+
+  // destroying the parser with connected slots releases them safely
+  parser->latencyRecordSignal.connect([](const MessageRecord&){});
+  parser.reset();
+}
+
+BOOST_FIXTURE_TEST_CASE(UnobservedMessagesAreIgnored, MessageParserTest)
+{
+  bool asyncHandlerCalled = false;
+  auto parser = MessageParser::create(
+    [&asyncHandlerCalled](auto task)
+    {
+      asyncHandlerCalled = true;
+      task();
+    }
+  );
+  parser->endOfStreamSignal.connect([](const std::string&){});
+
+  // nothing connected for element messages, so no task is posted
+  GstMessage* message = gst_message_new_element(nullptr, gst_structure_new_empty("test_structure"));
+  parser->parse(*message);
+  BOOST_CHECK(! asyncHandlerCalled);
+  gst_message_unref(message);
+
+  // GST_MESSAGE_STREAMS_SELECTED contains the bit of GST_MESSAGE_EOS, but is not observed
+  GstStreamCollection* collection = gst_stream_collection_new(nullptr);
+  message = gst_message_new_streams_selected(nullptr, collection);
+  gst_object_unref(collection);
+  parser->parse(*message);
+  BOOST_CHECK(! asyncHandlerCalled);
+  gst_message_unref(message);
+}
+
+BOOST_FIXTURE_TEST_CASE(AsyncMessagesAreBatchedAndHandledOnce, MessageParserTest)
+{
+  std::vector<std::function<void()>> tasks;
+  auto parser = MessageParser::create(
+    [&tasks](auto task)
+    {
+      tasks.push_back(std::move(task));
+    }
+  );
+  int endOfStreamCount = 0;
+  parser->endOfStreamSignal.connect([&endOfStreamCount](const std::string&){ ++endOfStreamCount; });
+
+  for(int i = 0; i < 3; ++i)
+  {
+    GstMessage* message = gst_message_new_eos(nullptr);
+    parser->parse(*message);
+    // the parser holds an own reference
+    gst_message_unref(message);
+  }
+  BOOST_CHECK_EQUAL(endOfStreamCount, 0);
+  BOOST_REQUIRE_EQUAL(tasks.size(), 1u);
+
+  tasks.front()();
+  BOOST_CHECK_EQUAL(endOfStreamCount, 3);
+  BOOST_CHECK_EQUAL(tasks.size(), 1u);
+
+  const auto stats = parser->getAsyncStats();
+  BOOST_CHECK_EQUAL(stats.messages, 3u);
+  BOOST_CHECK_EQUAL(stats.batches, 1u);
+  BOOST_CHECK_GE(stats.totalQueueLatency, stats.maxQueueLatency);
+}
+
+BOOST_FIXTURE_TEST_CASE(AsyncBatchSizeIsLimited, MessageParserTest)
+{
+  std::vector<std::function<void()>> tasks;
+  auto parser = MessageParser::create(
+    [&tasks](auto task)
+    {
+      tasks.push_back(std::move(task));
+    }
+  );
+  parser->setMaxBatchSize(2);
+  int endOfStreamCount = 0;
+  parser->endOfStreamSignal.connect([&endOfStreamCount](const std::string&){ ++endOfStreamCount; });
+
+  for(int i = 0; i < 3; ++i)
+  {
+    GstMessage* message = gst_message_new_eos(nullptr);
+    parser->parse(*message);
+    gst_message_unref(message);
+  }
+
+  tasks.at(0)();
+  BOOST_CHECK_EQUAL(endOfStreamCount, 2);
+  BOOST_REQUIRE_EQUAL(tasks.size(), 2u);
+
+  tasks.at(1)();
+  BOOST_CHECK_EQUAL(endOfStreamCount, 3);
+  BOOST_CHECK_EQUAL(tasks.size(), 2u);
+}
+
+BOOST_FIXTURE_TEST_CASE(PendingTaskKeepsParserAlive, MessageParserTest)
+{
+  std::vector<std::function<void()>> tasks;
+  auto parser = MessageParser::create(
+    [&tasks](auto task)
+    {
+      tasks.push_back(std::move(task));
+    }
+  );
+  bool signalCalled = false;
+  parser->endOfStreamSignal.connect([&signalCalled](const std::string&){ signalCalled = true; });
+
+  GstMessage* message = gst_message_new_eos(nullptr);
+  parser->parse(*message);
+  gst_message_unref(message);
+
+  std::weak_ptr<MessageParser> weakParser = parser;
+  parser.reset();
+  BOOST_CHECK(! weakParser.expired());
+
+  tasks.front()();
+  BOOST_CHECK(signalCalled);
+  BOOST_CHECK(weakParser.expired());
+}
+
+BOOST_FIXTURE_TEST_CASE(QosRecordSignalEmitted, MessageParserTest)
+{
+  auto parser = MessageParser::create();
+  bool signalCalled = false;
+
+  parser->qosRecordSignal.connect(
+    [&](const QosRecord& record)
+    {
+      signalCalled = true;
+      BOOST_CHECK_EQUAL(record.sourceName, "test_sink");
+      BOOST_CHECK(record.live);
+      BOOST_CHECK_EQUAL(record.runningTime, 10 * GST_SECOND);
+      BOOST_CHECK_EQUAL(record.jitter, 20 * GST_MSECOND);
+      BOOST_CHECK_CLOSE(record.proportion, 0.5, 0.001);
+      BOOST_CHECK_EQUAL(record.format, GST_FORMAT_BUFFERS);
+      BOOST_CHECK_EQUAL(record.processed, 100u);
+      BOOST_CHECK_EQUAL(record.dropped, 3u);
+    }
+  );
+
+  GstElement* element = gst_element_factory_make("fakesink", "test_sink");
+  GstMessage* message = gst_message_new_qos(GST_OBJECT(element), TRUE, 10 * GST_SECOND, 9 * GST_SECOND, 9 * GST_SECOND, 40 * GST_MSECOND);
+  gst_message_set_qos_values(message, 20 * GST_MSECOND, 0.5, 1000000);
+  gst_message_set_qos_stats(message, GST_FORMAT_BUFFERS, 100, 3);
+  parser->parse(*message);
+
+  BOOST_CHECK(signalCalled);
+
+  gst_message_unref(message);
+  gst_object_unref(element);
+}
+
+BOOST_FIXTURE_TEST_CASE(BufferingRecordSignalEmitted, MessageParserTest)
+{
+  auto parser = MessageParser::create();
+  gint receivedPercent = -1;
+
+  parser->bufferingRecordSignal.connect(
+    [&](const BufferingRecord& record)
+    {
+      receivedPercent = record.percent;
+    }
+  );
+
+  GstMessage* message = gst_message_new_buffering(nullptr, 42);
+  parser->parse(*message);
+  BOOST_CHECK_EQUAL(receivedPercent, 42);
+
+  gst_message_unref(message);
+}
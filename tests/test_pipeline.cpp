@@ -73,3 +73,108 @@ BOOST_FIXTURE_TEST_CASE(IsLiveTest, PipelineTest)
   livePipeline.setState(GST_STATE_NULL);
 }
 #endif
+
+BOOST_FIXTURE_TEST_CASE(LatencyMessagesRecalculateLatency, PipelineTest)
+{
+  const auto pipeline = Pipeline::create("latency_pipeline");
+  auto sink = gst_element_factory_make("fakesink", "sink");
+  BOOST_REQUIRE(sink);
+  gst_bin_add(GST_BIN(pipeline->getGstPipeline().get()), sink);
+
+  int doLatencyCount = 0;
+  g_signal_connect(
+    pipeline->getGstPipeline().get(),
+    "do-latency",
+    G_CALLBACK(+[](GstBin*, gpointer userData) -> gboolean
+    {
+      ++*static_cast<int*>(userData);
+      return TRUE;
+    }),
+    &doLatencyCount
+  );
+
+  auto parser = MessageParser::create();
+  auto connection = pipeline->enableLatencyRecalculation(*parser);
+  BOOST_CHECK(parser->getInterestMask() & GST_MESSAGE_LATENCY);
+
+  GstMessage* message = gst_message_new_latency(GST_OBJECT(sink));
+  parser->parse(*message);
+  gst_message_unref(message);
+  BOOST_CHECK_EQUAL(doLatencyCount, 1);
+
+  // elements of other pipelines are ignored
+  GstElement* otherSink = gst_element_factory_make("fakesink", "other_sink");
+  message = gst_message_new_latency(GST_OBJECT(otherSink));
+  parser->parse(*message);
+  gst_message_unref(message);
+  gst_object_unref(otherSink);
+  BOOST_CHECK_EQUAL(doLatencyCount, 1);
+
+  connection.disconnect();
+  BOOST_CHECK(! (parser->getInterestMask() & GST_MESSAGE_LATENCY));
+}
+
+BOOST_FIXTURE_TEST_CASE(LatencyQueryAndBreakdown, PipelineTest)
+{
+  auto pipeline = Pipeline::create(
+    Pipeline::fromDescription("videotestsrc name=src is-live=true ! video/x-raw,framerate=10/1 ! queue name=queue ! fakesink name=sink").getGstPipeline()
+  );
+  pipeline->setState(GST_STATE_PLAYING);
+  BOOST_REQUIRE_EQUAL(pipeline->getState(5 * GST_SECOND).result, GST_STATE_CHANGE_SUCCESS);
+
+  const auto latency = pipeline->queryLatency();
+  BOOST_REQUIRE(latency);
+  BOOST_CHECK(latency->live);
+  BOOST_CHECK_EQUAL(latency->min, 100 * GST_MSECOND); // one frame of the live source
+
+  const auto breakdown = pipeline->getLatencyBreakdown();
+  BOOST_REQUIRE(! breakdown.empty());
+  BOOST_CHECK_EQUAL(breakdown.front().elementName, "src");
+  BOOST_CHECK_EQUAL(breakdown.front().ownLatency, 100 * GST_MSECOND);
+  for(const auto& element : breakdown)
+  {
+    if(element.elementName == "queue")
+    {
+      BOOST_CHECK_EQUAL(element.ownLatency, 0u);
+      BOOST_CHECK_EQUAL(element.latency.min, 100 * GST_MSECOND);
+    }
+  }
+
+  BOOST_CHECK_EQUAL(pipeline->getLatency(), GST_CLOCK_TIME_NONE);
+  pipeline->setLatency(300 * GST_MSECOND);
+  BOOST_CHECK_EQUAL(pipeline->getLatency(), 300 * GST_MSECOND);
+  pipeline->setState(GST_STATE_NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(SeekAndStep, PipelineTest)
+{
+  auto pipeline = Pipeline::create(
+    Pipeline::fromDescription("videotestsrc ! video/x-raw,framerate=25/1 ! fakesink name=sink").getGstPipeline()
+  );
+  pipeline->setState(GST_STATE_PAUSED);
+  BOOST_REQUIRE_EQUAL(pipeline->getState(5 * GST_SECOND).result, GST_STATE_CHANGE_SUCCESS);
+
+  SeekOptions options;
+  options.accuracy = SeekAccuracy::Accurate;
+  const auto accurate = pipeline->seek(2 * GST_SECOND, options);
+  BOOST_CHECK(accurate.success);
+  BOOST_CHECK(GST_CLOCK_TIME_IS_VALID(accurate.duration));
+
+  gint64 position = -1;
+  BOOST_CHECK(gst_element_query_position(GST_ELEMENT(pipeline->getGstPipeline().get()), GST_FORMAT_TIME, &position));
+  BOOST_CHECK_EQUAL(position, static_cast<gint64>(2 * GST_SECOND));
+
+  options.accuracy = SeekAccuracy::KeyUnit;
+  options.trickMode = TrickMode::KeyUnits;
+  options.rate = 4.0;
+  BOOST_CHECK(pipeline->seek(GST_SECOND, options).success);
+
+  const auto stepped = pipeline->step(1);
+  BOOST_CHECK(stepped.success);
+  BOOST_CHECK(GST_CLOCK_TIME_IS_VALID(stepped.duration));
+  // no timeout
+  BOOST_CHECK(pipeline->step(1, GST_FORMAT_BUFFERS, GST_CLOCK_TIME_NONE).success);
+
+  BOOST_CHECK_THROW((void)pipeline->seek(0, SeekOptions{SeekAccuracy::KeyUnit, 0.0}), std::invalid_argument);
+  pipeline->setState(GST_STATE_NULL);
+}
@@ -0,0 +1,132 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_pipelinepool.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-24
+ */
+
+#include "pipelinepool.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+
+using namespace dh::gst;
+
+class PipelinePoolTest
+{
+public:
+  // Setup before first test case
+  PipelinePoolTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+namespace
+{
+std::shared_ptr<Pipeline> makeTestPipeline()
+{
+  return Pipeline::create(Pipeline::fromDescription("fakesrc num-buffers=5 ! fakesink").getGstPipeline());
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(InvalidParkStateThrows, PipelinePoolTest)
+{
+  BOOST_CHECK_THROW((void)PipelinePool::create(makeTestPipeline, 1, GST_STATE_PLAYING), std::invalid_argument);
+  BOOST_CHECK_THROW((void)PipelinePool::create(nullptr, 1), std::invalid_argument);
+}
+
+BOOST_FIXTURE_TEST_CASE(AcquiredPipelinesArePrerolled, PipelinePoolTest)
+{
+  std::atomic<int> created{0};
+  auto pool = PipelinePool::create([&]{ ++created; return makeTestPipeline(); }, 2);
+  BOOST_REQUIRE(pool->waitUntilFull(5 * GST_SECOND));
+  BOOST_CHECK_EQUAL(pool->getAvailableCount(), 2u);
+
+  auto pipeline = pool->acquire();
+  BOOST_CHECK_EQUAL(pipeline->getState(), GST_STATE_PAUSED);
+  BOOST_CHECK_EQUAL(pool->getMissCount(), 0u);
+
+  // the pool is refilled
+  BOOST_CHECK(pool->waitUntilFull(5 * GST_SECOND));
+  BOOST_CHECK_EQUAL(created.load(), 3);
+
+  pipeline->setState(GST_STATE_PLAYING);
+  auto message = pipeline->getBus()->timedPopFiltered(5 * GST_SECOND, GST_MESSAGE_EOS);
+  BOOST_CHECK(message);
+  pipeline->setState(GST_STATE_NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(EmptyPoolCountsMisses, PipelinePoolTest)
+{
+  auto pool = PipelinePool::create(makeTestPipeline, 0, GST_STATE_READY);
+  auto pipeline = pool->acquire();
+  BOOST_REQUIRE(pipeline);
+  BOOST_CHECK_EQUAL(pool->getMissCount(), 1u);
+}
+
+BOOST_FIXTURE_TEST_CASE(RecycledPipelinesAreParkedAgain, PipelinePoolTest)
+{
+  // only one pipeline can be built, so the pool can only be refilled by recycling
+  std::atomic<int> created{0};
+  auto pool = PipelinePool::create([&]{ return created++ == 0 ? makeTestPipeline() : nullptr; }, 1);
+  BOOST_REQUIRE(pool->waitUntilFull(5 * GST_SECOND));
+
+  auto pipeline = pool->acquire();
+  pipeline->setState(GST_STATE_PLAYING);
+  pool->recycle(pipeline);
+  BOOST_REQUIRE(pool->waitUntilFull(5 * GST_SECOND));
+  BOOST_CHECK_EQUAL(pipeline->getState(), GST_STATE_PAUSED);
+  BOOST_CHECK(pool->acquire() == pipeline);
+  BOOST_CHECK_GE(pool->getFailureCount(), 1u);
+  pipeline->setState(GST_STATE_NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(RecycledPipelinesHaveNoStaleMessages, PipelinePoolTest)
+{
+  std::atomic<int> created{0};
+  auto pool = PipelinePool::create([&]{ return created++ == 0 ? makeTestPipeline() : nullptr; }, 1);
+  BOOST_REQUIRE(pool->waitUntilFull(5 * GST_SECOND));
+
+  // the EOS stays on the bus, the user did not pop it
+  auto pipeline = pool->acquire();
+  pipeline->setState(GST_STATE_PLAYING);
+  BOOST_REQUIRE(pipeline->getState(5 * GST_SECOND).result == GST_STATE_CHANGE_SUCCESS);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  pool->recycle(pipeline);
+  BOOST_REQUIRE(pool->waitUntilFull(5 * GST_SECOND));
+
+  auto reused = pool->acquire();
+  BOOST_REQUIRE(reused == pipeline);
+  BOOST_CHECK(! reused->getBus()->timedPopFiltered(0, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR)));
+  reused->setState(GST_STATE_NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(RecycleIntoFullPoolDropsPipeline, PipelinePoolTest)
+{
+  auto pool = PipelinePool::create(makeTestPipeline, 1, GST_STATE_READY);
+  BOOST_REQUIRE(pool->waitUntilFull(5 * GST_SECOND));
+
+  auto extra = makeTestPipeline();
+  extra->setState(GST_STATE_READY);
+  pool->recycle(extra);
+  BOOST_CHECK_EQUAL(extra->getState(), GST_STATE_NULL);
+  BOOST_CHECK_EQUAL(pool->getAvailableCount(), 1u);
+}
+
+BOOST_FIXTURE_TEST_CASE(WaitUntilFullWithoutTimeout, PipelinePoolTest)
+{
+  auto pool = PipelinePool::create(makeTestPipeline, 1, GST_STATE_READY);
+  BOOST_CHECK(pool->waitUntilFull(GST_CLOCK_TIME_NONE));
+  BOOST_CHECK_EQUAL(pool->getAvailableCount(), 1u);
+}
@@ -0,0 +1,254 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_pipelinesupervisor.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-25
+ */
+
+#include "pipelinesupervisor.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace dh::gst;
+
+class PipelineSupervisorTest
+{
+public:
+  // Setup before first test case
+  PipelineSupervisorTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(InvalidSettingsThrow, PipelineSupervisorTest)
+{
+  BOOST_CHECK_THROW((void)PipelineSupervisor::create(PipelineSupervisor::Factory{}), std::invalid_argument);
+  auto supervisor = PipelineSupervisor::create("fakesrc ! fakesink");
+  BOOST_CHECK_THROW(supervisor->setBackoff(GST_SECOND, GST_MSECOND), std::invalid_argument);
+  BOOST_CHECK_THROW(supervisor->setJitter(1.5), std::invalid_argument);
+}
+
+BOOST_FIXTURE_TEST_CASE(RestartsAfterEndOfStream, PipelineSupervisorTest)
+{
+  auto supervisor = PipelineSupervisor::create("fakesrc num-buffers=1 ! fakesink");
+  supervisor->setBackoff(10 * GST_MSECOND, 50 * GST_MSECOND);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  int starts = 0;
+  supervisor->pipelineStartedSignal.connect(
+    [&](std::shared_ptr<Pipeline>)
+    {
+      std::lock_guard lock(mutex);
+      ++starts;
+      condition.notify_all();
+    }
+  );
+  supervisor->start();
+
+  std::unique_lock lock(mutex);
+  BOOST_CHECK(condition.wait_for(lock, std::chrono::seconds(10), [&]{ return starts >= 3; }));
+  lock.unlock();
+  supervisor->stop();
+
+  const auto stats = supervisor->getStats();
+  BOOST_CHECK_GE(stats.restarts, 2u);
+  BOOST_CHECK_EQUAL(stats.lastFailure, "end of stream");
+  BOOST_CHECK(GST_CLOCK_TIME_IS_VALID(stats.lastRecoveryTime));
+  BOOST_CHECK(! supervisor->getPipeline());
+}
+
+BOOST_FIXTURE_TEST_CASE(RestartsAfterError, PipelineSupervisorTest)
+{
+  auto supervisor = PipelineSupervisor::create("fakesrc is-live=true ! fakesink");
+  supervisor->setBackoff(10 * GST_MSECOND, 50 * GST_MSECOND);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::shared_ptr<Pipeline> pipeline;
+  std::string failure;
+  supervisor->pipelineStartedSignal.connect(
+    [&](std::shared_ptr<Pipeline> started)
+    {
+      std::lock_guard lock(mutex);
+      pipeline = started;
+      condition.notify_all();
+    }
+  );
+  supervisor->failureSignal.connect(
+    [&](const std::string& reason)
+    {
+      std::lock_guard lock(mutex);
+      failure = reason;
+      condition.notify_all();
+    }
+  );
+  supervisor->start();
+
+  std::unique_lock lock(mutex);
+  BOOST_REQUIRE(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return pipeline != nullptr; }));
+  const auto first = pipeline;
+  GError* error = g_error_new_literal(GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "camera disconnected");
+  first->getBus()->post(makeGstSharedPtr(gst_message_new_error(GST_OBJECT_CAST(first->getGstPipeline().get()), error, nullptr), TransferType::Full));
+  g_error_free(error);
+
+  BOOST_REQUIRE(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return pipeline != first; }));
+  BOOST_CHECK(failure.find("camera disconnected") != std::string::npos);
+  lock.unlock();
+
+  BOOST_CHECK_EQUAL(first->getState(), GST_STATE_NULL);
+  supervisor->stop();
+  BOOST_CHECK_EQUAL(supervisor->getStats().restarts, 1u);
+}
+
+BOOST_FIXTURE_TEST_CASE(FailedStartsBackOff, PipelineSupervisorTest)
+{
+  auto supervisor = PipelineSupervisor::create([]{ return std::shared_ptr<Pipeline>{}; });
+  supervisor->setBackoff(5 * GST_MSECOND, GST_SECOND);
+  supervisor->setJitter(0.0);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  int failures = 0;
+  supervisor->failureSignal.connect(
+    [&](const std::string&)
+    {
+      std::lock_guard lock(mutex);
+      ++failures;
+      condition.notify_all();
+    }
+  );
+  supervisor->start();
+
+  // 0 + 5 + 10 + 20ms
+  std::unique_lock lock(mutex);
+  BOOST_CHECK(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return failures >= 4; }));
+  lock.unlock();
+  supervisor->stop();
+
+  const auto stats = supervisor->getStats();
+  BOOST_CHECK_GE(stats.consecutiveFailures, 4u);
+  BOOST_CHECK_EQUAL(stats.restarts, 0u);
+  BOOST_CHECK_EQUAL(stats.lastFailure, "factory returned no pipeline");
+}
+
+BOOST_FIXTURE_TEST_CASE(MessagesStayOnTheBus, PipelineSupervisorTest)
+{
+  auto supervisor = PipelineSupervisor::create("fakesrc is-live=true ! fakesink");
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::shared_ptr<Pipeline> pipeline;
+  supervisor->pipelineStartedSignal.connect(
+    [&](std::shared_ptr<Pipeline> started)
+    {
+      std::lock_guard lock(mutex);
+      pipeline = started;
+      condition.notify_all();
+    }
+  );
+  supervisor->start();
+
+  std::unique_lock lock(mutex);
+  BOOST_REQUIRE(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return pipeline != nullptr; }));
+  lock.unlock();
+
+  // the supervisor does not pop the messages of the application
+  BOOST_CHECK(pipeline->getBus()->timedPopFiltered(0, GST_MESSAGE_STATE_CHANGED));
+  supervisor->stop();
+  BOOST_CHECK_EQUAL(supervisor->getStats().failures, 0u);
+}
+
+BOOST_FIXTURE_TEST_CASE(ExtendedMessagesDoNotRestart, PipelineSupervisorTest)
+{
+  auto supervisor = PipelineSupervisor::create("fakesrc is-live=true ! fakesink");
+  supervisor->setRestartOnEos(true);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::shared_ptr<Pipeline> pipeline;
+  supervisor->pipelineStartedSignal.connect(
+    [&](std::shared_ptr<Pipeline> started)
+    {
+      std::lock_guard lock(mutex);
+      pipeline = started;
+      condition.notify_all();
+    }
+  );
+  supervisor->start();
+
+  std::unique_lock lock(mutex);
+  BOOST_REQUIRE(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return pipeline != nullptr; }));
+  const auto first = pipeline;
+  lock.unlock();
+
+  // GST_MESSAGE_STREAMS_SELECTED contains the bit of GST_MESSAGE_EOS
+  GstStreamCollection* collection = gst_stream_collection_new(nullptr);
+  first->getBus()->post(makeGstSharedPtr(gst_message_new_streams_selected(GST_OBJECT_CAST(first->getGstPipeline().get()), collection), TransferType::Full));
+  gst_object_unref(collection);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  BOOST_CHECK_EQUAL(supervisor->getStats().failures, 0u);
+  BOOST_CHECK(supervisor->getPipeline() == first);
+  supervisor->stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(RestartFromSlot, PipelineSupervisorTest)
+{
+  auto supervisor = PipelineSupervisor::create("fakesrc is-live=true ! fakesink");
+  supervisor->setBackoff(10 * GST_MSECOND, 50 * GST_MSECOND);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<std::shared_ptr<Pipeline>> pipelines;
+  supervisor->pipelineStartedSignal.connect(
+    [&](std::shared_ptr<Pipeline> started)
+    {
+      std::unique_lock lock(mutex);
+      pipelines.push_back(started);
+      const bool first = pipelines.size() == 1;
+      condition.notify_all();
+      lock.unlock();
+      if(first)
+      {
+        supervisor->stop();
+        supervisor->start();
+      }
+    }
+  );
+  supervisor->start();
+
+  std::unique_lock lock(mutex);
+  BOOST_REQUIRE(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return pipelines.size() >= 2; }));
+  const auto second = pipelines.back();
+  lock.unlock();
+  BOOST_CHECK_EQUAL(pipelines.front()->getState(), GST_STATE_NULL);
+
+  // only one thread may handle the failure
+  GError* error = g_error_new_literal(GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "camera disconnected");
+  second->getBus()->post(makeGstSharedPtr(gst_message_new_error(GST_OBJECT_CAST(second->getGstPipeline().get()), error, nullptr), TransferType::Full));
+  g_error_free(error);
+
+  lock.lock();
+  BOOST_REQUIRE(condition.wait_for(lock, std::chrono::seconds(5), [&]{ return pipelines.size() >= 3; }));
+  lock.unlock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  BOOST_CHECK_EQUAL(supervisor->getStats().failures, 1u);
+  BOOST_CHECK(supervisor->getPipeline() == pipelines.back());
+  supervisor->stop();
+  BOOST_CHECK(! supervisor->getPipeline());
+}
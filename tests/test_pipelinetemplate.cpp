@@ -0,0 +1,120 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_pipelinetemplate.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-24
+ */
+
+#include "pipelinetemplate.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+using namespace dh::gst;
+
+class PipelineTemplateTest
+{
+public:
+  // Setup before first test case
+  PipelineTemplateTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(InstancesAreIndependent, PipelineTemplateTest)
+{
+  auto pipelineTemplate = PipelineTemplate::create("fakesrc name=src num-buffers=3 ! queue ! fakesink name=sink sync=true");
+  BOOST_REQUIRE(pipelineTemplate->isCompiled());
+
+  auto first = pipelineTemplate->instantiate({}, "first");
+  auto second = pipelineTemplate->instantiate({}, "second");
+  BOOST_CHECK_EQUAL(first->getName(), "first");
+
+  auto firstSource = first->getElementByName("src");
+  auto secondSource = second->getElementByName("src");
+  BOOST_REQUIRE(firstSource && secondSource);
+  BOOST_CHECK(firstSource->getGstElement() != secondSource->getGstElement());
+
+  gint numBuffers = 0;
+  g_object_get(G_OBJECT(firstSource->getGstElement().get()), "num-buffers", &numBuffers, nullptr);
+  BOOST_CHECK_EQUAL(numBuffers, 3);
+
+  gboolean sync = FALSE;
+  g_object_get(G_OBJECT(second->getElementByName("sink")->getGstElement().get()), "sync", &sync, nullptr);
+  BOOST_CHECK(sync);
+
+  // the links are recreated
+  auto sinkPad = makeGstSharedPtr(gst_element_get_static_pad(second->getElementByName("sink")->getGstElement().get(), "sink"), TransferType::Full);
+  BOOST_CHECK(gst_pad_is_linked(sinkPad.get()));
+
+  BOOST_CHECK(first->setState(GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+  auto message = first->getBus()->timedPopFiltered(5 * GST_SECOND, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  BOOST_REQUIRE(message);
+  BOOST_CHECK_EQUAL(GST_MESSAGE_TYPE(message.get()), GST_MESSAGE_EOS);
+  first->setState(GST_STATE_NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(ParametersAreSubstituted, PipelineTemplateTest)
+{
+  auto pipelineTemplate = PipelineTemplate::create("fakesrc ! filesink name=sink location=\"${label}\"");
+  BOOST_REQUIRE(pipelineTemplate->isCompiled());
+
+  auto pipeline = pipelineTemplate->instantiate({{"label", "camera-1"}});
+  gchar* label = nullptr;
+  g_object_get(G_OBJECT(pipeline->getElementByName("sink")->getGstElement().get()), "location", &label, nullptr);
+  BOOST_CHECK_EQUAL(std::string(label ? label : ""), "camera-1");
+  g_free(label);
+
+  BOOST_CHECK_THROW((void)pipelineTemplate->instantiate(), std::invalid_argument);
+}
+
+BOOST_FIXTURE_TEST_CASE(BinsAreParsedAgain, PipelineTemplateTest)
+{
+  auto pipelineTemplate = PipelineTemplate::create("fakesrc ! bin. ( name=bin queue ! fakesink )");
+  BOOST_CHECK(! pipelineTemplate->isCompiled());
+  BOOST_CHECK_NO_THROW((void)pipelineTemplate->instantiate());
+}
+
+BOOST_FIXTURE_TEST_CASE(InvalidDescriptionThrows, PipelineTemplateTest)
+{
+  BOOST_CHECK_THROW((void)PipelineTemplate::create("nonexistingelement ! fakesink"), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(InvalidPropertyValueThrows, PipelineTemplateTest)
+{
+  BOOST_CHECK_THROW((void)PipelineTemplate::create("fakesrc num-buffers=many ! fakesink"), std::runtime_error);
+  BOOST_CHECK_THROW((void)PipelineTemplate::create("fakesrc nonexistingproperty=1 ! fakesink"), std::runtime_error);
+
+  auto pipelineTemplate = PipelineTemplate::create("fakesrc num-buffers=${count} ! bin. ( name=bin queue ! fakesink )");
+  BOOST_REQUIRE(! pipelineTemplate->isCompiled());
+  BOOST_CHECK_NO_THROW((void)pipelineTemplate->instantiate({{"count", "3"}}));
+  BOOST_CHECK_THROW((void)pipelineTemplate->instantiate({{"count", "many"}}), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(ParsedValuesAreEscaped, PipelineTemplateTest)
+{
+  auto pipelineTemplate = PipelineTemplate::create(
+    "fakesrc ! bin. ( name=bin queue ! filesink name=quoted location=\"${label}\" ) "
+    "fakesrc ! filesink name=unquoted location=${label}"
+  );
+  BOOST_REQUIRE(! pipelineTemplate->isCompiled());
+
+  const std::string value = "a ! b \"c\" \\d";
+  auto pipeline = pipelineTemplate->instantiate({{"label", value}});
+  for(const auto* name : {"quoted", "unquoted"})
+  {
+    gchar* label = nullptr;
+    g_object_get(G_OBJECT(pipeline->getElementByName(name)->getGstElement().get()), "location", &label, nullptr);
+    BOOST_CHECK_EQUAL(std::string(label ? label : ""), value);
+    g_free(label);
+  }
+}
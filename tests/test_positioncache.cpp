@@ -0,0 +1,72 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_positioncache.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-28
+ */
+
+#include "positioncache.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+
+using namespace dh::gst;
+
+class PositionCacheTest
+{
+public:
+  // Setup before first test case
+  PositionCacheTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(InvalidIntervalThrows, PositionCacheTest)
+{
+  BOOST_CHECK_THROW((void)PositionCache::create(0), std::invalid_argument);
+}
+
+BOOST_FIXTURE_TEST_CASE(PositionIsUpdatedPeriodically, PositionCacheTest)
+{
+  auto pipeline = Pipeline::create(
+    Pipeline::fromDescription("videotestsrc is-live=true num-buffers=1000 ! fakesink sync=true").getGstPipeline()
+  );
+  auto cache = PositionCache::create(20 * GST_MSECOND);
+  auto position = cache->add(pipeline);
+  BOOST_CHECK_EQUAL(cache->getPipelineCount(), 1u);
+  BOOST_CHECK_EQUAL(position->getPosition(), GST_CLOCK_TIME_NONE);
+
+  pipeline->setState(GST_STATE_PLAYING);
+  BOOST_REQUIRE(pipeline->getState(5 * GST_SECOND).result != GST_STATE_CHANGE_FAILURE);
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+  const GstClockTime first = position->getPosition();
+  BOOST_REQUIRE(GST_CLOCK_TIME_IS_VALID(first));
+  BOOST_CHECK(GST_CLOCK_TIME_IS_VALID(position->getUpdateTime()));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  BOOST_CHECK_GT(position->getPosition(), first);
+  pipeline->setState(GST_STATE_NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(RegistrationEndsWithPosition, PositionCacheTest)
+{
+  auto pipeline = Pipeline::create("cached");
+  auto cache = PositionCache::create(GST_SECOND);
+  auto position = cache->add(pipeline);
+  cache->refresh();
+  BOOST_CHECK(GST_CLOCK_TIME_IS_VALID(position->getUpdateTime()));
+
+  position.reset();
+  BOOST_CHECK_EQUAL(cache->getPipelineCount(), 0u);
+}
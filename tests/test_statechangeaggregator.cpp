@@ -0,0 +1,123 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_statechangeaggregator.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-22
+ */
+
+#include "statechangeaggregator.hpp"
+#include "pipeline.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace dh::gst;
+
+class StateChangeAggregatorTest
+{
+public:
+  // Setup before first test case
+  StateChangeAggregatorTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+namespace
+{
+void postStateChange(MessageParser& parser, GstElement* element, GstState oldState, GstState newState, GstState pendingState)
+{
+  GstMessage* message = gst_message_new_state_changed(GST_OBJECT(element), oldState, newState, pendingState);
+  parser.parse(*message);
+  gst_message_unref(message);
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(CollapsesElementChangesIntoOneTransition, StateChangeAggregatorTest)
+{
+  auto pipeline = Pipeline::create("pipeline");
+  GstElement* sink = gst_element_factory_make("fakesink", "sink");
+  gst_bin_add(GST_BIN(pipeline->getGstPipeline().get()), sink);
+  GstElement* pipelineElement = GST_ELEMENT(pipeline->getGstPipeline().get());
+  GstElement* foreign = gst_element_factory_make("fakesink", "foreign");
+
+  auto parser = MessageParser::create();
+  auto aggregator = StateChangeAggregator::create(pipeline);
+  auto connection = aggregator->connect(*parser);
+
+  std::vector<StateTransition> transitions;
+  aggregator->transitionSignal.connect(
+    [&transitions](const StateTransition& transition)
+    {
+      transitions.push_back(transition);
+    }
+  );
+
+  postStateChange(*parser, sink, GST_STATE_NULL, GST_STATE_READY, GST_STATE_VOID_PENDING);
+  postStateChange(*parser, pipelineElement, GST_STATE_NULL, GST_STATE_READY, GST_STATE_PLAYING);
+  postStateChange(*parser, foreign, GST_STATE_NULL, GST_STATE_READY, GST_STATE_VOID_PENDING);
+  postStateChange(*parser, sink, GST_STATE_READY, GST_STATE_PAUSED, GST_STATE_VOID_PENDING);
+  postStateChange(*parser, pipelineElement, GST_STATE_READY, GST_STATE_PAUSED, GST_STATE_PLAYING);
+  BOOST_CHECK(transitions.empty());
+
+  postStateChange(*parser, sink, GST_STATE_PAUSED, GST_STATE_PLAYING, GST_STATE_VOID_PENDING);
+  postStateChange(*parser, pipelineElement, GST_STATE_PAUSED, GST_STATE_PLAYING, GST_STATE_VOID_PENDING);
+
+  BOOST_REQUIRE_EQUAL(transitions.size(), 1u);
+  const auto& transition = transitions.front();
+  BOOST_CHECK_EQUAL(transition.oldState, GST_STATE_NULL);
+  BOOST_CHECK_EQUAL(transition.newState, GST_STATE_PLAYING);
+  BOOST_REQUIRE_EQUAL(transition.elementChanges.size(), 6u);
+  BOOST_CHECK_EQUAL(std::string(g_quark_to_string(transition.elementChanges.front().elementName)), "sink");
+  BOOST_CHECK_EQUAL(transition.elementChanges.back().newState, GST_STATE_PLAYING);
+  BOOST_CHECK_GE(transition.duration, transition.elementChanges.back().offset);
+
+  // the next transition starts empty
+  aggregator->setKeepElementChanges(false);
+  postStateChange(*parser, pipelineElement, GST_STATE_PLAYING, GST_STATE_PAUSED, GST_STATE_VOID_PENDING);
+  BOOST_REQUIRE_EQUAL(transitions.size(), 2u);
+  BOOST_CHECK_EQUAL(transitions.back().oldState, GST_STATE_PLAYING);
+  BOOST_CHECK_EQUAL(transitions.back().newState, GST_STATE_PAUSED);
+  BOOST_CHECK(transitions.back().elementChanges.empty());
+
+  gst_object_unref(foreign);
+}
+
+BOOST_FIXTURE_TEST_CASE(SlotsCanCallTheAggregator, StateChangeAggregatorTest)
+{
+  auto pipeline = Pipeline::create("pipeline");
+  GstElement* pipelineElement = GST_ELEMENT(pipeline->getGstPipeline().get());
+
+  auto parser = MessageParser::create();
+  auto aggregator = StateChangeAggregator::create(pipeline);
+  auto connection = aggregator->connect(*parser);
+
+  unsigned transitions = 0;
+  aggregator->transitionSignal.connect(
+    [&](const StateTransition&)
+    {
+      ++transitions;
+      // must not deadlock
+      aggregator->reset();
+      aggregator->setKeepElementChanges(true);
+    }
+  );
+  postStateChange(*parser, pipelineElement, GST_STATE_NULL, GST_STATE_READY, GST_STATE_VOID_PENDING);
+  BOOST_CHECK_EQUAL(transitions, 1u);
+
+  // the connection does not keep the aggregator alive
+  aggregator->transitionSignal.disconnect_all_slots();
+  std::weak_ptr<StateChangeAggregator> weakAggregator = aggregator;
+  aggregator.reset();
+  BOOST_CHECK(weakAggregator.expired());
+  BOOST_CHECK(connection.connected());
+  BOOST_CHECK_NO_THROW(postStateChange(*parser, pipelineElement, GST_STATE_READY, GST_STATE_NULL, GST_STATE_VOID_PENDING));
+}
@@ -0,0 +1,113 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/**
+ * @file test_statetransitionprofiler.cpp
+ * @author Sandro Stiller
+ * @date 2025-07-26
+ */
+
+#include "statetransitionprofiler.hpp"
+#include "pipeline.hpp"
+
+#define BOOST_TEST_MODULE libdhgst_tests
+#include <boost/test/included/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+using namespace dh::gst;
+
+class StateTransitionProfilerTest
+{
+public:
+  // Setup before first test case
+  StateTransitionProfilerTest()
+  {
+    // Set G_DEBUG to fatal_criticals to make critical warnings crash the program
+    setenv("G_DEBUG", "fatal_criticals", 1);
+    gst_init(nullptr, nullptr);  // Initialize GStreamer
+  }
+};
+
+namespace
+{
+std::shared_ptr<Pipeline> makeTestPipeline()
+{
+  return Pipeline::create(Pipeline::fromDescription("fakesrc name=src ! fakesink name=sink").getGstPipeline());
+}
+
+bool hasEntry(const std::vector<StateTransitionProfiler::Entry>& report, const std::string& name, GstStateChange transition)
+{
+  return std::any_of(
+    report.begin(),
+    report.end(),
+    [&](const StateTransitionProfiler::Entry& entry){ return entry.elementName == name && entry.transition == transition; }
+  );
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(RecordsTransitionsOfAllElements, StateTransitionProfilerTest)
+{
+  auto pipeline = makeTestPipeline();
+  auto profiler = StateTransitionProfiler::create(pipeline);
+  profiler->start();
+  BOOST_CHECK(profiler->isRecording());
+
+  pipeline->setState(GST_STATE_PLAYING);
+  BOOST_REQUIRE_EQUAL(pipeline->getState(5 * GST_SECOND).result, GST_STATE_CHANGE_SUCCESS);
+  profiler->stop();
+  pipeline->setState(GST_STATE_NULL);
+
+  const auto report = profiler->getReport();
+  BOOST_CHECK(hasEntry(report, "src", GST_STATE_CHANGE_NULL_TO_READY));
+  BOOST_CHECK(hasEntry(report, "src", GST_STATE_CHANGE_PAUSED_TO_PLAYING));
+  BOOST_CHECK(hasEntry(report, pipeline->getName(), GST_STATE_CHANGE_READY_TO_PAUSED));
+
+  // the preroll of the sink is asynchronous
+  const auto sinkPreroll = std::find_if(
+    report.begin(),
+    report.end(),
+    [](const StateTransitionProfiler::Entry& entry)
+    {
+      return entry.elementName == "sink" && entry.transition == GST_STATE_CHANGE_READY_TO_PAUSED;
+    }
+  );
+  BOOST_REQUIRE(sinkPreroll != report.end());
+  BOOST_CHECK_EQUAL(sinkPreroll->result, GST_STATE_CHANGE_ASYNC);
+
+  // longest first
+  BOOST_CHECK(std::is_sorted(
+    report.begin(),
+    report.end(),
+    [](const auto& a, const auto& b){ return a.duration > b.duration; }
+  ));
+
+  std::ostringstream stream;
+  profiler->dump(stream);
+  BOOST_CHECK(stream.str().find("sink") != std::string::npos);
+}
+
+BOOST_FIXTURE_TEST_CASE(IgnoresOtherPipelines, StateTransitionProfilerTest)
+{
+  auto pipeline = makeTestPipeline();
+  auto other = makeTestPipeline();
+  auto profiler = StateTransitionProfiler::create(pipeline);
+  profiler->start();
+  other->setState(GST_STATE_READY);
+  profiler->stop();
+  other->setState(GST_STATE_NULL);
+
+  BOOST_CHECK(profiler->getReport().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(NothingIsRecordedWhenStopped, StateTransitionProfilerTest)
+{
+  auto pipeline = makeTestPipeline();
+  auto profiler = StateTransitionProfiler::create(pipeline);
+  pipeline->setState(GST_STATE_READY);
+  pipeline->setState(GST_STATE_NULL);
+  BOOST_CHECK(! profiler->isRecording());
+  BOOST_CHECK(profiler->getReport().empty());
+}